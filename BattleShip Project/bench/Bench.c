@@ -0,0 +1,559 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/Player.h"
+#include "../include/Bot.h"
+#include "../include/CalcProbs.h"
+#include "../include/ShipPlacement.h"
+#include "../include/BinomialHeap.h"
+#include "../include/coordslib.h"
+#include "../include/InputLib.h"
+#include "../include/Memory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#define NULL_SINK "NUL"
+#else
+#include <time.h>
+#define NULL_SINK "/dev/null"
+#endif
+
+/**
+ * Microbenchmarks of the engine kernels. GRIDSIZE is a compile-time constant, so the makefile's bench target builds this file once per
+ * grid size (-DGRIDSIZE=N) and runs every binary.
+ *
+ * Every kernel is run in batches. The batch size is doubled until a batch takes at least BENCH_MIN_BATCH_NS, then BENCH_REPETITIONS batches
+ * are timed and the mean and standard deviation of their ns/op are reported. Inputs are drawn from a fixed seed so runs are repeatable.
+ *
+ * The game prints to stdout all over the engine (and DisplayOpponentGrid is measured printing), so stdout is sent to a null sink and the
+ * results are written to stderr.
+ */
+
+#define BENCH_REPETITIONS 7
+#define BENCH_MIN_BATCH_NS 20000000.0
+#define BENCH_MAX_ITERATIONS (1 << 20)
+#define BENCH_SEED 0x5DEECE66DULL
+
+#pragma region [TIMING]
+
+static double NowNs(void){
+
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+#pragma endregion
+
+#pragma region [BENCH CONTEXT]
+
+/**
+ * State shared by the kernels. player has the game fleet placed from a fixed seed and fresh probability state. The other fields are
+ * scratch inputs that a kernel's setup fills for one batch and its teardown releases.
+ */
+typedef struct BenchContext {
+
+    Player * player;
+    unsigned long long rngState;
+
+    int iterations;
+
+    int (*cells)[2];
+    int (*areas)[4];
+    int * heapIndices;
+
+    char ** coords;
+    int * coordSplits;
+
+    int * heapValues;
+    int heapValueCount;
+    BinomialHeap * heap;
+    BinomialHeap * unionHeaps;
+
+} BenchContext;
+
+typedef struct Benchmark {
+
+    const char * name;
+
+    //setup and teardown are optional and not timed. run performs ctx->iterations operations.
+    void (*setup)(BenchContext * ctx);
+    void (*run)(BenchContext * ctx);
+    void (*teardown)(BenchContext * ctx);
+
+    //Caps the batch size of kernels whose inputs are too large to prepare in bulk (0 for BENCH_MAX_ITERATIONS).
+    int maxIterations;
+
+} Benchmark;
+
+static int RandomBelow(BenchContext * ctx, int bound){
+
+    return (int)(NextPlacementRandom(&ctx->rngState) % (unsigned long long)bound);
+}
+
+/**
+ * Fills ctx->areas with square areas the size of an artillery update around a sunk ship: the longest ship plus that much on each side,
+ * clamped to the grid.
+ */
+static void FillRandomAreas(BenchContext * ctx){
+
+    int reach = ctx->player->fleet.maxLength;
+
+    ctx->areas = (int (*)[4])(malloc(sizeof(int[4]) * ctx->iterations));
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        int row = RandomBelow(ctx, GRIDSIZE);
+        int col = RandomBelow(ctx, GRIDSIZE);
+
+        ctx->areas[k][0] = MAX(0, row - reach);
+        ctx->areas[k][1] = MIN(GRIDSIZE - 1, row + reach);
+        ctx->areas[k][2] = MAX(0, col - reach);
+        ctx->areas[k][3] = MIN(GRIDSIZE - 1, col + reach);
+    }
+}
+
+static void FillRandomCells(BenchContext * ctx){
+
+    ctx->cells = (int (*)[2])(malloc(sizeof(int[2]) * ctx->iterations));
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        ctx->cells[k][0] = RandomBelow(ctx, GRIDSIZE);
+        ctx->cells[k][1] = RandomBelow(ctx, GRIDSIZE);
+    }
+}
+
+static void FreeScratch(BenchContext * ctx){
+
+    free(ctx->cells);
+    free(ctx->areas);
+    free(ctx->heapIndices);
+
+    ctx->cells = NULL;
+    ctx->areas = NULL;
+    ctx->heapIndices = NULL;
+}
+
+/**
+ * Creates the benchmark player and places the game fleet on its grid from BENCH_SEED.
+ */
+static void InitializeBenchContext(BenchContext * ctx){
+
+    memset(ctx, 0, sizeof(BenchContext));
+    ctx->rngState = BENCH_SEED;
+
+    alloc_InitializePlayer(&ctx->player, "bench", 0, DUMB);
+
+    //The kernels update the player's probabilities, so it needs its own copy of the starting ones:
+    AcquireProbabilityState(ctx->player);
+
+    Fleet * fleet = &ctx->player->fleet;
+    int (*bounds)[4] = (int (*)[4])(malloc(sizeof(int[4]) * fleet->shipCount));
+
+    OccupancyBoard * board = (OccupancyBoard*)(malloc(sizeof(OccupancyBoard)));
+    InitializeOccupancyBoard(board);
+
+    if (GenerateRandomFleet(board, &fleet->length[1], fleet->shipCount, &ctx->rngState, bounds)){
+        for (int shipID = 1; shipID <= fleet->shipCount; shipID++)
+        {
+            PlaceShipAtBounds(ctx->player, shipID, ctx->player->grid, bounds[shipID - 1], NULL);
+        }
+    }
+
+    free(board);
+    free(bounds);
+}
+
+#pragma endregion
+
+#pragma region [PROBABILITY KERNELS]
+
+/**
+ * InitializeProbabilities allocates a new grid on every call, so it runs on a copy of the player and the grid is freed right after.
+ * The free is part of the measured time but is small next to the GRIDSIZE^2 cutoff calculations.
+ */
+static void RunInitializeProbabilities(BenchContext * ctx){
+
+    Player scratch = *ctx->player;
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        InitializeProbabilities(&scratch);
+
+        FreeProbabilityGrid(scratch.probabilityGrid);
+        FreeTracked(scratch.staleRegions);
+    }
+}
+
+static void RunUpdateSurroundingProbabilities(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        UpdateSurroundingProbabilities(ctx->player, ctx->cells[k]);
+    }
+}
+
+static void RunUpdateRegionProbabilities(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        UpdateRegionProbabilities(ctx->player, ctx->areas[k]);
+    }
+}
+
+#pragma endregion
+
+#pragma region [HEAP KERNELS]
+
+static void SetupHeapIndices(BenchContext * ctx){
+
+    ctx->heapIndices = (int*)(malloc(sizeof(int) * ctx->iterations));
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        ctx->heapIndices[k] = RandomBelow(ctx, (int)(PROB_REGION_COUNT));
+    }
+}
+
+static void RunUpdateHeap(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        UpdateHeap(ctx->player, ctx->heapIndices[k]);
+    }
+}
+
+static void RunUpdateHeapsWithinBounds(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        UpdateHeapsWithinBounds(ctx->player, ctx->areas[k][0], ctx->areas[k][1], ctx->areas[k][2], ctx->areas[k][3]);
+    }
+}
+
+/**
+ * The raw heap kernels use one element per grid cell, the size of a heap holding the whole board. The values live in ctx->heapValues
+ * so only nodes are allocated while the heap is built.
+ */
+static void AllocHeapValues(BenchContext * ctx, int count){
+
+    ctx->heapValueCount = count;
+    ctx->heapValues = (int*)(malloc(sizeof(int) * count));
+
+    for (int k = 0; k < count; k++)
+    {
+        ctx->heapValues[k] = RandomBelow(ctx, GRIDSIZE * GRIDSIZE);
+    }
+}
+
+static BinomialHeap * alloc_BenchHeap(BenchContext * ctx, int first, int count){
+
+    BinomialHeap * heap = ConstructBinomialHeap(NULL, 0, compareInt);
+
+    for (int k = first; k < first + count; k++)
+    {
+        insert(heap, &ctx->heapValues[k]);
+    }
+
+    return heap;
+}
+
+static void SetupHeapInsert(BenchContext * ctx){
+
+    AllocHeapValues(ctx, GRIDSIZE * GRIDSIZE + ctx->iterations);
+    ctx->heap = alloc_BenchHeap(ctx, 0, GRIDSIZE * GRIDSIZE);
+}
+
+static void RunHeapInsert(BenchContext * ctx){
+
+    for (int k = GRIDSIZE * GRIDSIZE; k < ctx->heapValueCount; k++)
+    {
+        insert(ctx->heap, &ctx->heapValues[k]);
+    }
+}
+
+static void SetupHeapDeleteMin(BenchContext * ctx){
+
+    AllocHeapValues(ctx, GRIDSIZE * GRIDSIZE + ctx->iterations);
+    ctx->heap = alloc_BenchHeap(ctx, 0, ctx->heapValueCount);
+}
+
+static void RunHeapDeleteMin(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        deleteMin(ctx->heap);
+    }
+}
+
+static void TeardownHeap(BenchContext * ctx){
+
+    FreeBinomialHeap(ctx->heap, NULL);
+    free(ctx->heapValues);
+
+    ctx->heap = NULL;
+    ctx->heapValues = NULL;
+}
+
+/**
+ * Union merges pairs of heaps of GRIDSIZE elements each. Union consumes its second heap, so every operation needs its own pair.
+ */
+static void SetupHeapUnion(BenchContext * ctx){
+
+    AllocHeapValues(ctx, 2 * GRIDSIZE * ctx->iterations);
+
+    ctx->unionHeaps = (BinomialHeap*)(malloc(sizeof(BinomialHeap) * 2 * ctx->iterations));
+
+    for (int k = 0; k < 2 * ctx->iterations; k++)
+    {
+        BinomialHeap * heap = alloc_BenchHeap(ctx, k * GRIDSIZE, GRIDSIZE);
+        ctx->unionHeaps[k] = *heap;
+        FreeTracked(heap);
+    }
+}
+
+static void RunHeapUnion(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        Union(&ctx->unionHeaps[2 * k], &ctx->unionHeaps[2 * k + 1]);
+    }
+}
+
+static void TeardownHeapUnion(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        ClearBinomialHeap(&ctx->unionHeaps[2 * k], NULL);
+    }
+
+    free(ctx->unionHeaps);
+    free(ctx->heapValues);
+
+    ctx->unionHeaps = NULL;
+    ctx->heapValues = NULL;
+}
+
+#pragma endregion
+
+#pragma region [COORDINATE KERNELS]
+
+static void SetupCoords(BenchContext * ctx){
+
+    ctx->coords = (char**)(malloc(sizeof(char*) * ctx->iterations));
+    ctx->coordSplits = (int*)(malloc(sizeof(int) * ctx->iterations));
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        ctx->coords[k] = alloc_GetCoordsFromIndices(RandomBelow(ctx, GRIDSIZE), RandomBelow(ctx, GRIDSIZE), GRIDSIZE, startingCoordinate_1,
+            startingCoordinate_2, endingCoordinate_1, endingCoordinate_2, coord_1_shift, coord_2_shift);
+
+        //The column numeral ends where the row digits start:
+        int split = 0;
+        while (ctx->coords[k][split] >= startingCoordinate_1 && ctx->coords[k][split] <= endingCoordinate_1) split++;
+        ctx->coordSplits[k] = split;
+    }
+}
+
+static void TeardownCoords(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        FreeTracked(ctx->coords[k]);
+    }
+
+    free(ctx->coords);
+    free(ctx->coordSplits);
+
+    ctx->coords = NULL;
+    ctx->coordSplits = NULL;
+}
+
+/**
+ * Converts both numerals of a coordinate, like alloc_ArrayCoordsFromUserCoords does, so one op is one full conversion.
+ */
+static void RunCoordToIndex(BenchContext * ctx){
+
+    volatile int sink = 0;
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        char * coords = ctx->coords[k];
+        int split = ctx->coordSplits[k];
+
+        sink += CoordToIndex(coords, 0, split, startingCoordinate_1, endingCoordinate_1, coord_1_shift);
+        sink += CoordToIndex(coords, split, (int)strlen(coords), startingCoordinate_2, endingCoordinate_2, coord_2_shift);
+    }
+}
+
+static void RunArrayCoordsFromUserCoords(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        FreeTracked(alloc_ArrayCoordsFromUserCoords(ctx->coords[k], NULL));
+    }
+}
+
+#pragma endregion
+
+#pragma region [GRID KERNELS]
+
+/**
+ * Checks random ship-sized areas (the longest ship of the fleet, half of them vertical) against the player's placed fleet.
+ */
+static void SetupShipAreas(BenchContext * ctx){
+
+    int length = MIN(ctx->player->fleet.maxLength, GRIDSIZE);
+
+    ctx->areas = (int (*)[4])(malloc(sizeof(int[4]) * ctx->iterations));
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        int vertical = RandomBelow(ctx, 2);
+        int row = RandomBelow(ctx, vertical ? GRIDSIZE - length + 1 : GRIDSIZE);
+        int col = RandomBelow(ctx, vertical ? GRIDSIZE : GRIDSIZE - length + 1);
+
+        ctx->areas[k][0] = row;
+        ctx->areas[k][1] = vertical ? row + length - 1 : row;
+        ctx->areas[k][2] = col;
+        ctx->areas[k][3] = vertical ? col : col + length - 1;
+    }
+}
+
+static void RunCheckForOverlap(BenchContext * ctx){
+
+    volatile int sink = 0;
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        sink += CheckForOverlap(ctx->player->grid, ctx->areas[k]);
+    }
+}
+
+static void RunDisplayOpponentGrid(BenchContext * ctx){
+
+    for (int k = 0; k < ctx->iterations; k++)
+    {
+        DisplayOpponentGrid(ctx->player->grid, GRIDSIZE, 1);
+    }
+
+    fflush(stdout);
+}
+
+#pragma endregion
+
+#pragma region [RUNNER]
+
+static void SetupCells(BenchContext * ctx){ FillRandomCells(ctx); }
+static void SetupAreas(BenchContext * ctx){ FillRandomAreas(ctx); }
+
+static const Benchmark Benchmarks[] = {
+    {"InitializeProbabilities", NULL, RunInitializeProbabilities, NULL, 0},
+    {"UpdateSurroundingProbabilities", SetupCells, RunUpdateSurroundingProbabilities, FreeScratch, 0},
+    {"UpdateRegionProbabilities", SetupAreas, RunUpdateRegionProbabilities, FreeScratch, 0},
+    {"UpdateHeap", SetupHeapIndices, RunUpdateHeap, FreeScratch, 0},
+    {"UpdateHeapsWithinBounds", SetupAreas, RunUpdateHeapsWithinBounds, FreeScratch, 0},
+    {"BinomialHeap insert", SetupHeapInsert, RunHeapInsert, TeardownHeap, 0},
+    {"BinomialHeap deleteMin", SetupHeapDeleteMin, RunHeapDeleteMin, TeardownHeap, 0},
+    {"BinomialHeap Union", SetupHeapUnion, RunHeapUnion, TeardownHeapUnion, 1024},
+    {"CoordToIndex", SetupCoords, RunCoordToIndex, TeardownCoords, 0},
+    {"alloc_ArrayCoordsFromUserCoords", SetupCoords, RunArrayCoordsFromUserCoords, TeardownCoords, 0},
+    {"CheckForOverlap", SetupShipAreas, RunCheckForOverlap, FreeScratch, 0},
+    {"DisplayOpponentGrid (null sink)", NULL, RunDisplayOpponentGrid, NULL, 0},
+};
+
+/**
+ * Times one batch of ctx->iterations operations and returns the elapsed nanoseconds. Setup and teardown are not timed.
+ */
+static double TimeBatch(const Benchmark * bench, BenchContext * ctx){
+
+    if (bench->setup != NULL) bench->setup(ctx);
+
+    double start = NowNs();
+    bench->run(ctx);
+    double elapsed = NowNs() - start;
+
+    if (bench->teardown != NULL) bench->teardown(ctx);
+
+    return elapsed;
+}
+
+static void RunBenchmark(const Benchmark * bench, BenchContext * ctx){
+
+    int maxIterations = (bench->maxIterations > 0) ? bench->maxIterations : BENCH_MAX_ITERATIONS;
+
+    //Calibrate the batch size (this also warms up the caches and the allocator):
+    ctx->iterations = 1;
+    while (TimeBatch(bench, ctx) < BENCH_MIN_BATCH_NS && ctx->iterations < maxIterations)
+    {
+        ctx->iterations = MIN(2 * ctx->iterations, maxIterations);
+    }
+
+    double nsPerOp[BENCH_REPETITIONS];
+    double mean = 0;
+
+    for (int r = 0; r < BENCH_REPETITIONS; r++)
+    {
+        nsPerOp[r] = TimeBatch(bench, ctx) / ctx->iterations;
+        mean += nsPerOp[r];
+    }
+    mean /= BENCH_REPETITIONS;
+
+    double variance = 0;
+    for (int r = 0; r < BENCH_REPETITIONS; r++)
+    {
+        variance += (nsPerOp[r] - mean) * (nsPerOp[r] - mean);
+    }
+    variance /= BENCH_REPETITIONS - 1;
+
+    double stddev = sqrt(variance);
+
+    fprintf(stderr, "%-34s %6d %16.1f %14.1f %7.2f%% %9d x %d\n", bench->name, GRIDSIZE, mean, stddev,
+        (mean > 0) ? 100.0 * stddev / mean : 0.0, ctx->iterations, BENCH_REPETITIONS);
+}
+
+/**
+ * Runs every kernel, or only those whose name contains one of the arguments.
+ */
+int main(int argc, char ** argv){
+
+    if (freopen(NULL_SINK, "w", stdout) == NULL){
+        fprintf(stderr, "Could not open the null sink %s.\n", NULL_SINK);
+        return 1;
+    }
+
+    BenchContext ctx;
+    InitializeBenchContext(&ctx);
+
+    fprintf(stderr, "%-34s %6s %16s %14s %8s %s\n", "kernel", "grid", "ns/op", "stddev", "cv", "batch");
+
+    for (int b = 0; b < (int)(sizeof(Benchmarks) / sizeof(Benchmarks[0])); b++)
+    {
+        int selected = (argc <= 1);
+        for (int a = 1; a < argc && !selected; a++)
+        {
+            selected = (strstr(Benchmarks[b].name, argv[a]) != NULL);
+        }
+
+        if (selected) RunBenchmark(&Benchmarks[b], &ctx);
+    }
+
+    FreePlayer(ctx.player);
+
+    return 0;
+}
+
+#pragma endregion
@@ -3,9 +3,9 @@
 
 #define ATTACKS
 
-int Fire(char *coords, char** attacked, int easyMode, char ** outputMsg);
+int Fire(char *coords, Player* player, Player* attacked, int easyMode, char ** outputMsg);
 
-int performRadarSweep(char *inputC, Player* player, char ** outputMsg);
+int performRadarSweep(char *inputC, Player* player, Player* opp, char ** outputMsg);
 
 int applySmokeScreen(char *coords, Player* player, Player * opponent, char ** outputMsg);
 
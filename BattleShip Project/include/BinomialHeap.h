@@ -37,6 +37,10 @@ void* findMin(BinomialHeap * heap);
 
 void* deleteMin(BinomialHeap * heap);
 
+void ClearBinomialHeap(BinomialHeap * heap, void (*freeValue)(void*));
+
+void FreeBinomialHeap(BinomialHeap * heap, void (*freeValue)(void*));
+
 
 void InOrderTraversalTree_INT(Node * root);
 
@@ -1,6 +1,7 @@
 #ifndef BOT
 #define BOT
 
+#include <stddef.h>
 #include "BinomialHeap.h"
 #include "D_LinkedList.h"
 
@@ -13,27 +14,60 @@ typedef enum BotIQ{
 #define TASKFLAG_LOWPRIORITY 0
 #define TASKFLAG_HIGHPRIORITY 1
 
-typedef struct{
+#define TASKQUEUE_BOARDS 4 //Opponents a bot can have tasks queued against: every other player of a free-for-all game.
+
+typedef enum BotTaskKind{
+    TASK_FIRE,      //Fire at (row, col) of the target.
+    TASK_DROPPED    //Left in the slot of a task that was moved to the top of the queue. Skipped when reached.
+} BotTaskKind;
+
+/**
+ * A task carries its arguments inline, so queuing one is a copy into the bot's task queue and never allocates.
+ */
+typedef struct BotTask{
+    Player * target;
+    int row;
+    int col;
+    unsigned char kind;     //BotTaskKind
+    unsigned char priority; //TASKFLAG_LOWPRIORITY or TASKFLAG_HIGHPRIORITY
+} BotTask;
 
-    /**
-     * Function pointer to a task function. A valid task function should return an integer whether it successfully executed or not. The arguments
-     * could be decoded from the void*.
-     * This approach is easier to use than a variadic function for our specific purposes.
-     */
-    int (*function)(void**);
+/**
+ * The bot's stack memory: a ring buffer of tasks owned by the bot. High priority tasks are pushed at the front and are performed first,
+ * low priority ones are pushed at the back. The buffer is allocated with the bot and only grows (doubling) when it is full.
+ */
+typedef struct BotTaskQueue{
+    BotTask * tasks;
+    int capacity;   //A power of 2, so indices wrap with a mask.
+    int head;       //Index of the next task.
+    int count;
 
-    /**
-     * This void pointer could represent an array of arguments. These arguments could be passed into a function that knows how to read them correctly.
-     */
-    void ** arguments;
-    int argumentCount;
+    //One bitset per opponent board, with a bit per cell (row * GRIDSIZE + col) set while a task for it is queued, so a cell of a board
+    //is never queued twice. A board's bitset is allocated by the first task queued against it.
+    Player * queuedBoards[TASKQUEUE_BOARDS];
+    unsigned char * queued[TASKQUEUE_BOARDS];
+} BotTaskQueue;
 
-    void ** flags;
-    int flagCount;
+static inline int IsTaskQueueEmpty(BotTaskQueue * queue){
 
-} BotTask;
+    return queue->count == 0;
+}
+
+/**
+ * Returns the next task without popping it, or NULL if there is none. Dropped tasks on top of the queue are discarded on the way.
+ */
+static inline BotTask * PeekTask(BotTaskQueue * queue){
+
+    while (queue->count > 0 && queue->tasks[queue->head].kind == TASK_DROPPED)
+    {
+        queue->head = (queue->head + 1) & (queue->capacity - 1);
+        queue->count--;
+    }
+
+    return queue->count == 0 ? NULL : &queue->tasks[queue->head];
+}
 
-void PlaceBotShips(Player * bot);
+void PlaceBotShips(Player * bot, Player ** opponents, int opponentCount);
 
 void BotSmartAttack(Player * bot, Player * opponent);
 
@@ -41,6 +75,8 @@ void BotAverageAttack(Player * bot, Player * opponent);
 
 void BotDumbAttack(Player * bot, Player * opponent);
 
+int BotPickTarget(Player * bot, Player ** players, int playerCount);
+
 int GetRandomProbCoordinateFromCategory(int * row, int * col, D_LinkedList * heapCategory);
 
 int GetRandomHighestProbCell(int * row, int* col, Player * player);
@@ -49,24 +85,32 @@ int GetHighestProbCoordinateFromCategory(int * row, int * col, D_LinkedList * he
 
 int GetHighestProbability(int * row, int* col, Player * player);
 
+int GetHighestUnresolvedCell(int * row, int * col, Player * player);
+
 int UpdateHeap(Player * player, int heapIndex);
 
 int UpdateHeapsWithinBounds(Player * player, int row0, int row1, int col0, int col1);
 
-BotTask * GetNextTask(Player * bot);
+void UpdateShotProbabilities(Player * target, int row, int col, int sunkShipID);
+
+int InitializeTaskQueue(BotTaskQueue * queue, int capacity);
 
-BotTask * CreateTask(int (*function)(void**), void** arguments, int argumentCount, void** flags, int flagCount);
+int GetNextTask(Player * bot, BotTask * task);
 
-int freeTask(BotTask * task);
+void FreeBotStackMemory(Player * bot);
 
-int AssignNewTask(int priorityFlag,  Player * bot, int (*function)(void**), void** arguments, int argumentCount, void** flags, int flagCount);
+int AssignNewTask(int priorityFlag, Player * bot, BotTaskKind kind, int row, int col, Player * target);
 
-int PerformTask(BotTask * task);
+int PerformTask(Player * bot, BotTask * task);
 
-int BotFire(void** args);
+int IsTargetCellPossible(Player * opponent, int row, int col);
 
 int BotFireHelper(int row, int col, Player * bot, Player * opponent);
 
-void PlaceBotShips(Player * bot);
+void PlaceBotShips(Player * bot, Player ** opponents, int opponentCount);
+
+void PlaceBotShipsRandomly(Player * bot);
+
+void PlaceBotShipsAgainstDensity(Player * bot, int ** density);
 
 #endif
\ No newline at end of file
@@ -5,6 +5,23 @@
 
 typedef struct Player Player;
 
+/**
+ * Full recomputes (the starting grid, heap construction, and UpdateRegionProbabilities() after a sink) split the grid in row bands
+ * computed by the OpenMP threads. Every cell only depends on the grid and the fleet, so the result is the same as a serial pass. Below this
+ * many cells, they run on the calling thread, since waking the threads costs more than the work.
+ */
+#define PROB_PARALLEL_MINCELLS 16384
+
+/**
+ * Boards of at least this many cells are evaluated lazily. The bot only ever reads the top of a few region heaps, so instead of keeping
+ * every cell up to date, UpdateSurroundingProbabilities() and UpdateRegionProbabilities() only mark the regions they would recompute as
+ * stale (see MarkRegionsStale()). A stale region keeps its heap and its category until a query needs it (its heap being picked, a
+ * display of the grid), which recomputes its cells with RefineRegion(). The starting grid is not computed either: every region starts stale.
+ */
+#ifndef PROB_LAZY_MINCELLS
+#define PROB_LAZY_MINCELLS 65536
+#endif
+
 /**
  * Calculates the number of possible placements for a ship in a specific square
  * without exceeding the boundaries and updates the probability grid.
@@ -34,7 +51,7 @@ int CalcOverlapProb(Player *player, int target[2]);
  * Updates the surrounding probabilities of a target square after an attack.
  * 
  * Recalculates probabilities for all surrounding cells based on the state of the grid
- * and excludes sunk ships from calculations.
+ * and excludes sunk ships from calculations. On lazy boards, their regions are marked stale instead.
  * 
  * @param player Pointer to the Player structure containing the grid and probability grid.
  * @param target A 2-element array representing the target square coordinates.
@@ -53,4 +70,25 @@ int UpdateSurroundingProbabilities(Player *player, int target[2]);
  */
 int CheckHitOrMiss(char** grid, int target[2]);
 
+/**
+ * Recalculates the probabilities of every cell in a rectangular region of the grid.
+ * 
+ * Cells that are hits, misses or part of a sunk ship are skipped. Large regions are split across threads (see PROB_PARALLEL_MINCELLS).
+ * On lazy boards, the regions covering it are marked stale instead (see PROB_LAZY_MINCELLS).
+ * 
+ * @param player Pointer to the Player structure containing the grid and probability grid.
+ * @param target A 4-element array {startRow, endRow, startCol, endCol}, bounds included.
+ * @return 1 if the function worked properly, 0 otherwise.
+ */
+int UpdateRegionProbabilities(Player *player, int target[4]);
+
+/**
+ * Retires the length of a ship that just sank from the probabilities surrounding it.
+ * 
+ * @param player Pointer to the Player structure whose ship sank.
+ * @param shipID The ID of the sunk ship, as stored in the player's shipIdGrid.
+ * @return 1 if the probabilities were updated, 0 otherwise.
+ */
+int RetireSunkShip(Player *player, int shipID);
+
 #endif // CALCPROBS_H
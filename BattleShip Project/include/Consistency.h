@@ -0,0 +1,31 @@
+#ifndef CONSISTENCY
+#define CONSISTENCY
+
+/**
+ * Safety net for the incremental probability updates. UpdateSurroundingProbabilities() and RetireSunkShip() only recompute the cells they
+ * expect a shot to change, so everything else keeps the value it had. After every bot move, the checker recomputes every cell from
+ * scratch (the same CalcCutoffProb() and CalcOverlapProb() calls, on a separate grid) and reports how far the incremental state drifted:
+ *  - Grid: unresolved cells whose value differs from the full recompute, with the largest and the mean difference.
+ *  - Heaps: elements holding a stale probability, elements left on resolved cells, targetable cells missing from their region heap,
+ *    and regions sitting in the wrong category list (or in none).
+ *
+ * It is compiled in only with -DENABLE_CONSISTENCY_CHECK (the makefile's check target builds bin/main_check). Otherwise the macro expands
+ * to nothing. One line is written per checked move, and a summary at exit, to stderr or to the file named by the BATTLESHIP_CONSISTENCY
+ * environment variable.
+ */
+
+#ifdef ENABLE_CONSISTENCY_CHECK
+
+typedef struct Player Player;
+
+void CheckProbabilityConsistency(Player * player);
+
+#define CONSISTENCY_CHECK(player) CheckProbabilityConsistency(player)
+
+#else
+
+#define CONSISTENCY_CHECK(player) ((void)0)
+
+#endif
+
+#endif
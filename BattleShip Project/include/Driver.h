@@ -21,7 +21,9 @@
 
 #define DRIVER
 
-const int PlayerCount = 2;
+#define MAXPLAYERCOUNT playerColorCount
+
+int PlayerCount = 2; //Two in PVP and PVE, up to MAXPLAYERCOUNT in free-for-all games.
 int currPlayer;
 GameMode gameMode;
 
@@ -0,0 +1,15 @@
+#ifndef MAPPEDFILE
+#define MAPPEDFILE
+
+#include <stddef.h>
+
+/**
+ * Read-only mappings of whole files (mmap, or a file mapping on Windows), used by the stores the game keeps on disk (opening books and
+ * player profiles). Mappings are shared, so every process mapping the same file reads the same pages of the page cache, and nothing is
+ * copied until a page is read.
+ */
+
+const void * MapReadOnlyFile(const char * path, size_t * size);
+void UnmapReadOnlyFile(const void * mapping, size_t size);
+
+#endif
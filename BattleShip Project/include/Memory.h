@@ -0,0 +1,37 @@
+#ifndef MEMORY
+#define MEMORY
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Every allocation of the engine goes through alloc_Tracked() with the subsystem it belongs to, and is released with FreeTracked().
+ * Each subsystem keeps its current and peak bytes, so a process running game after game can check that a game gives back everything it
+ * took (TotalMemoryInUse() returns to its starting value once the game is torn down, see FreePlayer() and FreeGame(), apart from the starting
+ * probability template kept for the next game, see CloseProbabilityTemplate()).
+ *
+ * A block carries a small header with its size and subsystem, so FreeTracked() needs nothing but the pointer. Memory from alloc_Tracked()
+ * must never be passed to free(), and the other way around. The counters are atomic since fleets are generated on several threads.
+ */
+
+typedef enum MemorySubsystem{
+    MEM_PLAYERS,    //Player structs, player arrays and fleet arrays.
+    MEM_GRIDS,      //Game, ship ID, smoke, probability and radar grids, and the placement boards.
+    MEM_HEAPS,      //Binomial heaps, their nodes and the probability elements they hold.
+    MEM_LISTS,      //Linked lists and their nodes (probability categories, bot stack memory).
+    MEM_TASKS,      //Bot task queues.
+    MEM_STRINGS,    //Names, messages, input tokens and coordinates.
+    MEMSUBSYSTEMCOUNT
+} MemorySubsystem;
+
+void * alloc_Tracked(MemorySubsystem subsystem, size_t size);
+void * alloc_TrackedZeroed(MemorySubsystem subsystem, size_t count, size_t size);
+void FreeTracked(void * ptr);
+
+size_t MemoryInUse(MemorySubsystem subsystem);
+size_t MemoryPeak(MemorySubsystem subsystem);
+size_t TotalMemoryInUse();
+void ResetMemoryPeaks();
+void PrintMemoryReport(FILE * out);
+
+#endif
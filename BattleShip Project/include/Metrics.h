@@ -0,0 +1,71 @@
+#ifndef METRICS
+#define METRICS
+
+#include "InputLib.h"
+
+/**
+ * Instrumentation of the engine: latency histograms of the phases of every bot move and of every human command, and counters of the
+ * work the engine does. It is compiled in only with -DENABLE_METRICS (the makefile's metrics target builds bin/main_metrics). Otherwise
+ * every macro below expands to nothing, so the game pays nothing for it.
+ *
+ * The summary is written on exit, on SIGINT/SIGTERM, and on SIGUSR1 (SIGBREAK on Windows) at the start of the next turn. It goes to
+ * stderr, or to the file named by the BATTLESHIP_METRICS environment variable.
+ */
+
+typedef enum MetricTimer{
+    TIMER_BOT_MOVE,                 //A whole bot turn.
+    TIMER_BOT_OPPONENT_SELECTION,   //Free-for-all games: picking which player to attack.
+    TIMER_BOT_TARGET_SELECTION,     //Picking the cell to fire at from the probability regions.
+    TIMER_BOT_TASK_PROCESSING,      //Popping and performing stacked tasks. Includes the shot the task fires.
+    TIMER_BOT_PROBABILITY_UPDATE,   //Probability grid updates after a shot and after a sink.
+    TIMER_BOT_HEAP_REFRESH,         //Region heap updates after a shot and after a sink.
+    TIMER_COMMAND_FIRST,            //One timer per InputOps value of PerformOperation(), from here.
+    METRICTIMERCOUNT = TIMER_COMMAND_FIRST + TOTALINSTRUCTIONCOUNT
+} MetricTimer;
+
+typedef enum MetricCounter{
+    COUNTER_CELLS_RECOMPUTED,
+    COUNTER_HEAP_INSERTS,
+    COUNTER_HEAP_DELETES,
+    COUNTER_ALLOCATIONS,            //Heap nodes and elements, task queue growth.
+    COUNTER_TASKS_QUEUED,
+    COUNTER_TRANSPOSITION_HITS,
+    COUNTER_TRANSPOSITION_MISSES,
+    COUNTER_REGIONS_REFINED,        //Stale regions of lazy boards computed by a query.
+    METRICCOUNTERCOUNT
+} MetricCounter;
+
+unsigned long long MetricsNow();
+
+#ifdef ENABLE_METRICS
+
+#include <stdio.h>
+#include <stdatomic.h>
+
+//Atomic, since the full probability recomputes count from several threads:
+extern atomic_ullong MetricCounters[METRICCOUNTERCOUNT];
+
+void InitializeMetrics();
+void RecordMetricTime(MetricTimer timer, unsigned long long ns);
+void PollMetricsDump();
+void DumpMetrics(FILE * out);
+
+#define METRICS_INITIALIZE() InitializeMetrics()
+#define METRICS_POLL() PollMetricsDump()
+#define METRIC_COUNT(counter) atomic_fetch_add_explicit(&MetricCounters[counter], 1, memory_order_relaxed)
+#define METRIC_ADD(counter, n) atomic_fetch_add_explicit(&MetricCounters[counter], (unsigned long long)(n), memory_order_relaxed)
+#define METRIC_TIMER_START(name) unsigned long long name = MetricsNow()
+#define METRIC_TIMER_STOP(timer, name) RecordMetricTime(timer, MetricsNow() - name)
+
+#else
+
+#define METRICS_INITIALIZE() ((void)0)
+#define METRICS_POLL() ((void)0)
+#define METRIC_COUNT(counter) ((void)0)
+#define METRIC_ADD(counter, n) ((void)0)
+#define METRIC_TIMER_START(name) ((void)0)
+#define METRIC_TIMER_STOP(timer, name) ((void)0)
+
+#endif
+
+#endif
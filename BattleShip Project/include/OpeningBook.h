@@ -0,0 +1,47 @@
+#ifndef OPENINGBOOK
+#define OPENINGBOOK
+
+#include "defs.h"
+
+typedef struct Player Player;
+typedef struct Fleet Fleet;
+
+/**
+ * Until the first hit, a game always starts from the same position for a given grid size and fleet, so its starting probability grid and
+ * the strong shots to open with can be computed once and stored. An opening book file holds, for one configuration:
+ *  - the starting probability grid, which InitializeProbabilities() copies instead of computing it,
+ *  - OPENINGBOOK_LINECOUNT opening lines of OPENINGBOOK_LINELENGTH shots, each made by repeatedly picking one of the most probable cells
+ *    and assuming it misses. A bot picks one line at random and plays it while its target has not been hit yet.
+ *
+ * The configuration is the grid size, the number of ships of each length and OPENINGBOOK_VERSION, which covers the file layout and the
+ * probability formulas of CalcProbs.c (bump it when they change, so old books are ignored instead of giving wrong grids). Books are looked
+ * for in the directory named by the BATTLESHIP_BOOK_DIR environment variable, or in books/, under opening_<GRIDSIZE>_<key>.book. They are
+ * written by the makefile's book target (tools/BuildBook.c).
+ *
+ * A book is mapped read-only (mmap, or a file mapping on Windows) the first time it is needed, so every game process running the same
+ * configuration shares the same physical pages. When no book matches, everything is computed as before.
+ */
+
+#define OPENINGBOOK_VERSION 1
+
+#ifndef OPENINGBOOK_LINECOUNT
+#define OPENINGBOOK_LINECOUNT 8
+#endif
+
+#ifndef OPENINGBOOK_LINELENGTH
+#define OPENINGBOOK_LINELENGTH 16
+#endif
+
+/**
+ * A cell is a candidate for the next shot of a line when its probability is at least this percentage of the highest one. Lower values
+ * make the lines more varied, 100 makes them follow the highest probability.
+ */
+#define OPENINGBOOK_CANDIDATE_PERCENT 90
+
+int LoadOpeningGrid(Player * player);
+int NextOpeningShot(Player * bot, Player * opponent, int * row, int * col);
+void CloseOpeningBook();
+
+int WriteOpeningBook(const char * directory, const int * shipLengths, int shipCount, unsigned long long seed, char ** outputPath);
+
+#endif
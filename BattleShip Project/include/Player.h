@@ -7,19 +7,40 @@
 #include "InputLib.h"
 #include "ShortcutFuncs.h"
 #include "UITools.h"
-#include "BinomialHeap.h"
 #include "D_LinkedList.h"
+#include "ProbabilityHeap.h"
 #include "Bot.h"
+#include "Weapons.h"
+#include "Profiles.h"
 
 #define playerColorCount 5 
+#define MAXOPPONENTCOUNT (playerColorCount - 1)
 
 extern char * PlayerColors[playerColorCount];
 
-typedef struct ShipBounds {
-    int startRow, startCol, endRow, endCol;
-    bool IsSunk;
-    //bool isSunk;
-} ShipBounds;
+/**
+ * A player's ships, stored as one array per field instead of one struct per ship. Every array is indexed by ship ID and has shipCount + 1
+ * entries (entry NOSHIP_ID is never used), so a ship ID read from the shipIdGrid indexes them directly.
+ * 
+ * Loops that only care about how many ships of each length are still afloat (like the probability calculations) go over afloatByLength,
+ * which has maxLength + 1 entries, instead of going over every ship.
+ */
+typedef struct Fleet {
+    int shipCount;
+    int maxLength;
+
+    int * startRow;
+    int * endRow;
+    int * startCol;
+    int * endCol;
+    int * length;
+    int * hits; //Incremented by the attacks every time one of the ship's cells is hit. The ship is sunk once hits reaches length.
+    bool * sunk;
+
+    int unhitCells; //Ship cells that were not hit yet, over the whole fleet.
+
+    int * afloatByLength;
+} Fleet;
 
 
 
@@ -47,97 +68,224 @@ typedef struct ShipBounds {
 #define LOW_RISK 0
 
 
+typedef struct ProbabilityTemplate ProbabilityTemplate;
+
 typedef struct Player{
 
-    char *name;
+    /**
+     * The fields read on every shot come first, so a turn touches a few cache lines of the struct. The ones only read to display the player,
+     * to place ships or to record the game are at the end.
+     */
     char** grid;
-    bool** smokeGrid;
-    int usedsmokes;
-    ShipBounds carrierBounds;
-    ShipBounds battleshipBounds;
-    ShipBounds destroyerBounds;
-    ShipBounds submarineBounds;
-    
-    int prevSunk;
-    int currSunkShips; //This stores the current number of sunk ships (the number of sunk ships at the end of the previous turn)
-    int sweepsLeft;  // Variable for tracking the remaining sweeps
-    //Note: Grid size is not set here. Player grids are allocated dynamically when the game starts.
 
-    char * UIColor;
+    /**
+     * Stores the ID of the ship occupying each cell (NOSHIP_ID for water). It is filled when ships are placed and never modified afterwards,
+     * so even after a cell becomes HIT we know which ship it belonged to in O(1).
+     */
+    unsigned char** shipIdGrid;
 
-    bool isBot;
-    BotIQ botIQ;
-    int ** probabilityGrid;
+    /**
+     * Everything below describes what the attackers know about THIS player's grid, not what this player knows about others. Since the hits
+     * and misses on a grid are seen by everyone, every attacker shares the same probability grid and heaps of a target. With N players this
+     * keeps the memory and the update cost at N boards instead of one board per (attacker, target) pair.
+     *
+     * The rows of the probability grid are one block (see alloc_ProbabilityGrid()), and probabilities take 16 bits (see ProbabilityHeap.h).
+     */
+    ProbabilityValue ** probabilityGrid;
 
     /**
-     * This is an array of probability heaps. Each heap stores the coordinates of a region in the grid ordering them by probability. This way
-     * we maintain that the time complexity of finding the highest probability coordinate in a k by k region is O(1).
-     * 
-     * The elements stored in the heaps will be key-value pairs:
-     *      - key: probability
-     *      - value: grid coordinate (i,j)
-     * 
+     * Zobrist hash of what attackers know about this player: the resolved cells and the ships afloat of each length (see Transposition.h).
+     */
+    unsigned long long knowledgeHash;
+
+    /**
+     * Boards of at least PROB_LAZY_MINCELLS cells are evaluated lazily (see CalcProbs.h): one flag per region, set while the region's cells
+     * and heap are out of date. NULL on eager boards.
+     */
+    unsigned char * staleRegions;
+
+    /**
+     * The starting probability state of the player's configuration while the player shares it (see Player.c): the probabilityGrid points
+     * into it and must not be written, and the player has no heaps. AcquireProbabilityState() gives the player its own. NULL otherwise.
+     * A new player has neither (every probability field is NULL) until PrepareProbabilityGrid() or AcquireProbabilityState() is called.
+     */
+    ProbabilityTemplate * probabilityTemplate;
+
+    /**
+     * This is an array of probability heaps, one per region of the grid (see HashRegion()). Each heap stores the cells of its region ordering
+     * them by probability. This way we maintain that the time complexity of finding the highest probability coordinate in a k by k region is O(1).
+     * The nodes of every heap are in probabilityNodes, indexed by cell (see ProbabilityHeap.h), so the heaps allocate nothing while playing.
      * 
-     * The array will be initialized with three slots:
-     *      - index 0: null chance probability regions
-     *      - index 1: low probability regions
-     *      - index 2: avg probability regions
-     *      - index 3: high probability regions
+     * The heaps are filed in three category lists:
+     *      - index 0: low probability regions
+     *      - index 1: avg probability regions
+     *      - index 2: high probability regions
      * 
-     * Throughout the game certain regions will lose or gain probability. When that happens, they will be moved between the three arrays and placed
+     * Throughout the game certain regions will lose or gain probability. When that happens, they will be moved between the three lists and placed
      * in the corresponding one.
      * 
-     * How we determine in which array a certain priority queue is placed:
+     * How we determine in which list a certain heap is placed:
      *      When the probabilities of some region are updated, the entire heap is reassembeled which takes O(k) where k is the size of the largest
      *      ship so O(1). According to the highest probability in the heap we can know whether the region falls in low, average, or high probability range.
-     *      According to the range, we decide where to move it.
+     *      According to the range, we decide where to move it. Every heap remembers its list and its node in it, so moving it is O(1)
+     *      (see FileProbabilityHeap()).
      * 
      * This method solves two main problems:
      *      - Bot predictability
      *      - Accessing the highest probability in O(1)
      */
-    BinomialHeap ** probabilityHeapSet;
-    //BinomialHeap *** probabilityHeapArray;
-    D_LinkedList * probabilityHeapCategoryLists; //This pointer represents an array of linked lists.
+    ProbabilityHeap * probabilityHeapSet;
+    ProbabilityNode * probabilityNodes;
+    D_LinkedList * probabilityHeapCategoryLists; //This pointer represents an array of linked lists of ProbabilityHeap pointers.
+
+    /**
+     * Hunt lattice: the heaps only hold the cells where (row + col) % huntStride == huntOffset. Every huntStride consecutive cells of a row
+     * or a column contain exactly one of them, so with huntStride set to the length of the smallest ship afloat, no ship can avoid the
+     * lattice and the other cells never need to be hunted. It is picked again when the last ship of that length sinks (see
+     * UpdateHuntLattice()). A huntStride of 1 keeps every cell.
+     */
+    int huntStride;
+    int huntOffset;
+
+    Fleet fleet;
+    
+    int sunkShipCount; //Maintained incrementally by RegisterShipHit(), so reading the number of sunk ships is O(1).
+    int enemyShipsSunk; //Number of ships this player sunk, across all of its opponents.
+    int resolvedCells; //Number of cells of this player's grid that attackers know the content of (HIT, or MISS when misses are shown).
+    int prevSunk;
+    int currSunkShips; //This stores the current number of sunk ships (the number of sunk ships at the end of the previous turn)
+    //Note: Grid size is not set here. Player grids are allocated dynamically when the game starts.
+
+    bool isBot;
+    BotIQ botIQ;
 
     int currTargetCategory; //This is used to allow the bot to follow a pattern picking once from every category every time.
 
-    //Stack Memory:
-    D_LinkedList * stackMemory;
+    //Stack Memory (bots only, empty for humans):
+    BotTaskQueue stackMemory;
+
+    //Opening book line the bot plays while its target was not hit yet (-1 until it is picked), and its next shot in that line:
+    int openingLine;
+    int openingMove;
 
     //Risk Variables:
     int riskFactor;
 
+    /**
+     * Where this player placed their ships in past games (see Profiles.h), added to the probabilityGrid by CalcCutoffProb(). NULL for bots
+     * and for players that were never recorded.
+     */
+    PlacementPrior * placementPrior;
+
+    bool** smokeGrid;
+    int weaponUses[WEAPONCOUNT]; //How many times the player used each weapon of the WeaponTable (used for ammo rules).
+
+    /**
+     * Summed-area (integral) table of the cells a radar can detect: ship cells (hit or not) that are not covered by smoke.
+     * It has GRIDSIZE + 1 rows and columns, radarAreaTable[i][j] holds the count for the rectangle [0, i) x [0, j), so counting the
+     * detectable cells of any rectangle takes 4 lookups. It only changes when a ship is placed or smoke is applied, and each of those
+     * only recomputes the entries below and to the right of the modified area.
+     */
+    int** radarAreaTable;
+
+    /**
+     * The first PROFILE_EARLYSHOTS cells this player fired at in the game (row * GRIDSIZE + col), in order. They go to the player's profile
+     * when the game is over, so bots can keep their ships away from where the player usually starts searching. NULL for bots.
+     */
+    int * earlyShots;
+    int earlyShotCount;
+
+    /**
+     * When misses are hidden (hard difficulty) the grid never shows them, but this player still knows where they missed. One bitset per
+     * opponent (bit row * GRIDSIZE + col) and the count of its set bits, allocated on the first hidden miss against that opponent (see
+     * RecordHiddenMiss()).
+     */
+    Player * hiddenMissTargets[MAXOPPONENTCOUNT];
+    unsigned char * hiddenMisses[MAXOPPONENTCOUNT];
+    int hiddenMissCount[MAXOPPONENTCOUNT];
+
+    char *name;
+    char * UIColor;
+
 }Player;
 
 
+int HashRegion(int i, int j);
+
+static inline int IsHuntCell(const Player * player, int row, int col){
+    return (row + col) % player->huntStride == player->huntOffset;
+}
+
+static inline int IsStaleCell(const Player * player, int row, int col){
+    return player->staleRegions != NULL && player->staleRegions[HashRegion(row, col)];
+}
+
 Player ** alloc_InitializePlayerArray(int playerCount, Player *** playersArray);
 Player* alloc_InitializePlayer(Player** output, char* playerName, int isBot, BotIQ botIQ);
+void FreePlayer(Player * player);
+void FreePlayerArray(Player ** players, int playerCount);
+
+ProbabilityValue ** alloc_ProbabilityGrid(void);
+void FreeProbabilityGrid(ProbabilityValue ** grid);
 
 int InitializeProbabilities(Player * player);
 
 int InitializeProbabilityHeaps(Player * player);
+int UpdateHuntLattice(Player * player);
+int WidenHuntLattice(Player * player);
+void FreeProbabilityState(Player * player);
 
-int HashRegion(int i, int j);
-
+int PrepareProbabilityGrid(Player * player);
+int AcquireProbabilityState(Player * player);
+void ReleaseProbabilityTemplate(Player * player);
+void PrewarmProbabilityTemplate();
+void CloseProbabilityTemplate();
 
-int InitializeBotStackMemory(Player * bot);
+int MarkRegionsStale(Player * player, int row0, int row1, int col0, int col1);
+int RefineRegion(Player * player, int region);
+int FileProbabilityHeap(Player * player, int region);
+void RefineProbabilities(Player * player);
 
-int* BinHeap_FindHighestProbabilityCell(BinomialHeap * binHeap);
 
-void InOrderTraversalTree_ProbNode(Node * root);
-void InOrderTraversal_ProbNode_Print(BinomialHeap * heap);
+int InitializeBotStackMemory(Player * bot);
 
 void DisplayGrid(char ** grid, int gridSize);
-void DisplayIntGrid(int ** grid, int gridSize);
+void DisplayIntGrid(ProbabilityValue ** grid, int gridSize);
+void DisplayProbabilityGrid(Player * player);
 
 void DisplayOpponentGrid(char ** grid, int gridSize, int showMiss);
 
 
 
+int SetGameFleet(const int * shipLengths, int shipCount);
+
+int InitializeFleet(Fleet * fleet, const int * shipLengths, int shipCount);
+
+void FreeFleet(Fleet * fleet);
+
+int IsShipID(Player * player, int shipID);
+
+char ShipCharFromLength(int length);
+
+char * ShipTypeName(int length);
+
+int RegisterShipHit(Player * player, int shipID);
+
+int InitializeRadarAreaTable(Player * player);
+
+int UpdateRadarAreaTable(Player * player, int row0, int col0);
+
+int QueryRadarArea(Player * player, int row0, int row1, int col0, int col1);
+
 int countSunkShips(Player* player);
 
-int checkIfSunk(Player *player, ShipBounds* shipBounds);
+int IsPlayerAlive(Player* player);
+
+void RecordHiddenMiss(Player * attacker, Player * target, int row, int col);
+
+double ExpectedHitChance(Player * attacker, Player * target);
+
+int checkIfSunk(Player *player, int shipID);
 
 void ShowPlayerStats(Player * player);
 
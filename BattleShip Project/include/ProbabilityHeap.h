@@ -0,0 +1,59 @@
+#ifndef PROBABILITYHEAP
+#define PROBABILITYHEAP
+
+#include <limits.h>
+#include "D_LinkedList.h"
+
+/**
+ * Probabilities are placement counts: at most 2 * (5 + 4 + 3 + 3 + 2) with the standard fleet, plus what the hits, the misses and a
+ * placement prior add or remove. 16 bits leave plenty of room for bigger fleets, and values are clamped to the range when they are written.
+ */
+typedef short ProbabilityValue;
+
+#define PROBABILITY_MAX SHRT_MAX
+#define PROBABILITY_MIN SHRT_MIN
+
+static inline ProbabilityValue ToProbabilityValue(int value){
+
+    return (ProbabilityValue)((value > PROBABILITY_MAX) ? PROBABILITY_MAX : (value < PROBABILITY_MIN) ? PROBABILITY_MIN : value);
+}
+
+#define NOCELL -1
+
+/**
+ * Max binomial heaps of grid cells, keyed by probability, for the probability regions of a player (see Player.h).
+ *
+ * A cell is in at most one heap at a time, so the nodes of every heap of a player live in a single array indexed by cell
+ * (row * GRIDSIZE + col) and nothing is allocated or freed while playing. The links are cell indices: a node takes 12 bytes, where a
+ * BinomialHeap Node (40 bytes) and the {probability, row, col} element it pointed to were two separate allocations. Emptying a heap is O(1),
+ * its nodes are simply overwritten by the next insertions.
+ */
+typedef struct ProbabilityNode{
+    int leftChild;                  //NOCELL if there is none.
+    int rightSibling;               //NOCELL if there is none.
+    ProbabilityValue probability;
+    unsigned char degree;
+} ProbabilityNode;
+
+typedef struct ProbabilityHeap{
+    int head;                       //First root, NOCELL when the heap is empty.
+    int top;                        //Cell with the highest probability (the first inserted between equal ones), NOCELL when empty.
+    ProbabilityValue topProbability;
+
+    //Owned by Player.c: the category list the heap is filed in (-1 for none) and its node in that list, so it moves in O(1).
+    signed char category;
+    D_ListNode * categoryNode;
+} ProbabilityHeap;
+
+static inline int IsProbabilityHeapEmpty(const ProbabilityHeap * heap){
+    return heap->head == NOCELL;
+}
+
+void InitializeProbabilityHeap(ProbabilityHeap * heap);
+void ClearProbabilityHeap(ProbabilityHeap * heap);
+
+void ProbabilityHeapInsert(ProbabilityNode * nodes, ProbabilityHeap * heap, int cell, ProbabilityValue probability);
+
+int ProbabilityHeapCells(const ProbabilityNode * nodes, const ProbabilityHeap * heap, int * cells);
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef PROFILES
+#define PROFILES
+
+#include "defs.h"
+
+typedef struct Player Player;
+
+/**
+ * Records of the human players across games, keyed by player name. For every player, the store keeps a heatmap per ship length of where
+ * they placed their ships, where every older game counts PROFILE_DECAY times less than the next one. When a bot attacks a known player, the
+ * heatmaps are blended into the player's probability grid as a prior: CalcCutoffProb() adds, for each length still afloat, how often the
+ * player covered the cell with a ship of that length, scaled to the placement counts it computes.
+ *
+ * The store also keeps how the player searches: a decayed heatmap of the cells they fired at within their first PROFILE_EARLYSHOTS shots,
+ * with the share of those shots on each parity of the grid and near its edges. AddEarlyCoverage() turns them into the chance the player
+ * covers each cell early, which smart bots place their fleet away from (see PlaceBotShips()). Every game is folded into the record when it
+ * is flushed, so loading a player that played thousands of games reads one record, like loading a new one.
+ *
+ * The store is one file per grid size, profiles_<GRIDSIZE>.store, in the directory named by BATTLESHIP_PROFILE_DIR or in profiles/.
+ * It is a log of records that is only ever appended to: a game queues the placements and shots of its human players, and FlushProfiles() appends one
+ * new version of each of their records in a single write when the game is over. The last record of a name is the current one. When the old
+ * versions take more than PROFILE_COMPACT_RATIO times the space of the current ones, the file is rewritten with the current ones only.
+ *
+ * Lookups are zero-copy: the store is mapped read-only (see MappedFile.h) and a player's prior points into the mapping, so it costs nothing
+ * to attach and nothing per move beyond reading the heatmaps. The store stays mapped until FlushProfiles() or CloseProfileStore(), which
+ * must only be called once the players holding a prior are freed.
+ */
+
+#define PROFILE_VERSION 2
+
+#define PROFILE_NAMELENGTH 32
+
+/**
+ * Number of distinct ship lengths a record keeps heatmaps for. Lengths beyond the first PROFILE_LENGTHSLOTS a player was seen with are not
+ * recorded.
+ */
+#define PROFILE_LENGTHSLOTS 8
+
+#define PROFILE_DECAY 0.9f
+
+/**
+ * Weight of the prior. At 100, a cell the player covered with a ship of length L in every recorded game gains 2 * L, as much as the
+ * placements of that ship through a cell far from the edges.
+ */
+#define PROFILE_PRIOR_PERCENT 100
+
+#define PROFILE_COMPACT_RATIO 2
+
+#ifndef PROFILE_EARLYSHOTS
+#define PROFILE_EARLYSHOTS 64
+#endif
+
+/**
+ * Shots within this many cells of the border count as edge shots.
+ */
+#define PROFILE_EDGEBAND 2
+
+/**
+ * The parity and edge shares predict the early coverage of a cell as if they came from this many games, so a player with little history
+ * is modelled by how they search rather than by the few cells they happened to shoot. The heatmap takes over as games accumulate.
+ */
+#define PROFILE_SHOTPRIOR_GAMES 2
+
+/**
+ * A cell the opponent always shoots early weighs this many times the highest probability of the bot's own grid when it places its fleet.
+ */
+#define PROFILE_COVERAGE_WEIGHT 4
+
+/**
+ * What CalcCutoffProb() reads from a player's record: one heatmap per length of the current fleet the player has history for, and the
+ * factor turning its values into placement counts.
+ */
+typedef struct PlacementPrior{
+    int count;
+    int length[PROFILE_LENGTHSLOTS];
+    float scale[PROFILE_LENGTHSLOTS];
+    const float * heat[PROFILE_LENGTHSLOTS]; //GRIDSIZE * GRIDSIZE values, row by row, inside the mapped store.
+} PlacementPrior;
+
+PlacementPrior * alloc_PlacementPrior(Player * player);
+
+void RecordEarlyShot(Player * player, int row, int col);
+int AddEarlyCoverage(Player * player, int ** density, int weight);
+
+void QueueProfile(Player * player);
+int FlushProfiles();
+void CloseProfileStore();
+
+/**
+ * Prior of a cell given which lengths are still afloat: a ship that sank no longer needs to be found, so its heatmap stops counting.
+ */
+static inline int PlacementPriorBonus(const PlacementPrior * prior, const int * afloatByLength, int row, int col){
+
+    float bonus = 0.0f;
+    int cell = row * GRIDSIZE + col;
+
+    for (int s = 0; s < prior->count; s++)
+    {
+        if (afloatByLength[prior->length[s]] > 0) bonus += prior->scale[s] * prior->heat[s][cell];
+    }
+
+    return (int)(bonus + 0.5f);
+}
+
+#endif
@@ -8,8 +8,46 @@
 #define SHIPPLACEMENT
 
 void ModifyGridArea(char **grid, int rowSize, int * bounds, char c);
-void setShipBounds(int startRow, int startCol, int endRow, int endCol, ShipBounds* shipBounds);
-int PlaceShipOnGridHelper(Player *player, char shipChar, char **grid, char coords[], char orientation[], int ship_size[2], char ** outputMsg);
-int PlaceShipOnGridHorizontal(Player *player,char shipChar, char **grid, char coords[], int ship_size[2], char ** outputMsg);
+void setShipBounds(int startRow, int endRow, int startCol, int endCol, Fleet* fleet, int shipID);
+int PlaceShipOnGridHelper(Player *player, int shipID, char **grid, char coords[], char orientation[], int ship_size[2], char ** outputMsg);
+int PlaceShipOnGridHorizontal(Player *player, int shipID, char **grid, char coords[], int ship_size[2], char ** outputMsg);
+int PlaceShipAtBounds(Player *player, int shipID, char **grid, int shipbounds[4], char ** outputMsg);
 int CheckForOverlap(char **grid, int bounds[]);
+
+/**
+ * Occupancy bitmask of a grid used by the random fleet generator. Bit j of rows[i] is set when cell (i, j) is occupied, and cols holds the
+ * same bits transposed so vertical placements can be computed the same way as horizontal ones. usedRows and usedCols list, in increasing
+ * order, the lines that contain at least one occupied cell; every other line accepts a ship at all of its anchors without looking at its bits.
+ */
+#define OCCUPANCY_WORDS ((GRIDSIZE + 63) / 64)
+
+typedef struct OccupancyBoard {
+    unsigned long long rows[GRIDSIZE][OCCUPANCY_WORDS];
+    unsigned long long cols[GRIDSIZE][OCCUPANCY_WORDS];
+    bool rowUsed[GRIDSIZE];
+    bool colUsed[GRIDSIZE];
+    int usedRows[GRIDSIZE];
+    int usedCols[GRIDSIZE];
+    int usedRowCount;
+    int usedColCount;
+} OccupancyBoard;
+
+void InitializeOccupancyBoard(OccupancyBoard * board);
+void ClearOccupancyBoard(OccupancyBoard * board);
+void MarkOccupied(OccupancyBoard * board, int bounds[4]);
+unsigned long long NextPlacementRandom(unsigned long long * state);
+int CountShipAnchors(OccupancyBoard * board, int shipLength);
+int PickRandomShipPlacement(OccupancyBoard * board, int shipLength, unsigned long long * rngState, int bounds[4]);
+int GenerateRandomFleet(OccupancyBoard * board, const int * shipLengths, int shipCount, unsigned long long * rngState, int (*outBounds)[4]);
+int GenerateRandomFleets(int fleetCount, const int * shipLengths, int shipCount, unsigned long long seed, int (*outBounds)[4]);
+
+/**
+ * Number of random fleets the low density placement scores before keeping the best one.
+ */
+#define LOWDENSITY_CANDIDATES 4096
+
+int ** alloc_DensityAreaTable(int ** density);
+void FreeDensityAreaTable(int ** table);
+int ShipDensityScore(int ** densityTable, int bounds[4]);
+long long PickLowDensityFleet(OccupancyBoard * base, int ** densityTable, const int * shipLengths, int shipCount, int candidateCount, unsigned long long seed, int (*outBounds)[4]);
 #endif
\ No newline at end of file
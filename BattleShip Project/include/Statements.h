@@ -15,7 +15,10 @@
 #define REQUEST_ANYKEY "Press <enter> to continue..."
 #define REQUEST_OPERATION "Please enter the operation you'd like to perform (eg. Fire A1): "
 #define REQUEST_STARTINPUT "Type start to begin or quit to exit: "
-#define REQUEST_GAMEMODE "Please specify the game mode (PVP or PVE): "
+#define REQUEST_GAMEMODE "Please specify the game mode (PVP, PVE or FFA): "
+#define REQUEST_PLAYERCOUNT "How many players will play? (2 to 5)"
+#define REQUEST_BOTCOUNT "How many of them are bots?"
+#define REQUEST_TARGET "Which player do you want to attack?"
 #define REQUEST_DIFFICULTY "Choose the difficulty (easy or hard): "
 #define REQUEST_PLAYERNAME "Please enter the player's name: "
 #define REQUEST_COORDINATE "Please enter the coordinate (eg. A1): "
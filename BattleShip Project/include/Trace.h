@@ -0,0 +1,44 @@
+#ifndef TRACE
+#define TRACE
+
+/**
+ * Timeline of a whole game in the Chrome trace-event format. The file opens directly in chrome://tracing, Perfetto or Speedscope, where
+ * every turn shows up with the bot's decisions, the probability updates, the heap updates and the rendering nested under it.
+ *
+ * It is compiled in only with -DENABLE_TRACE (the makefile's trace target builds bin/main_trace). Otherwise the macros expand to nothing.
+ *
+ * TRACE_SCOPE(name) opens a span that ends when the enclosing block is left, whichever return or goto leaves it (gcc's cleanup
+ * attribute). Put it at the top of the function, before any label, so no goto jumps over it. name must be a string literal.
+ *
+ * Spans are stored in a buffer owned by the thread that records them, so recording takes no lock. The trace is written at exit and on
+ * SIGINT/SIGTERM, to the file named by the BATTLESHIP_TRACE environment variable or to trace.json.
+ */
+
+#ifdef ENABLE_TRACE
+
+#include <stdio.h>
+
+typedef struct TraceSpan{
+    const char * name;
+    unsigned long long start;
+} TraceSpan;
+
+void InitializeTrace();
+TraceSpan BeginTraceSpan(const char * name);
+void EndTraceSpan(TraceSpan * span);
+void WriteTrace(FILE * out);
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_INITIALIZE() InitializeTrace()
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__) __attribute__((cleanup(EndTraceSpan))) = BeginTraceSpan(name)
+
+#else
+
+#define TRACE_INITIALIZE() ((void)0)
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef TRANSPOSITION
+#define TRANSPOSITION
+
+#include "defs.h"
+
+typedef struct Player Player;
+typedef struct Fleet Fleet;
+
+/**
+ * What attackers know about a player is the set of cells that are HIT or MISS and how many ships of each length are still afloat. Until a
+ * ship sinks, the probability grid follows from it alone, so results computed from that grid can be reused whenever the same knowledge
+ * comes back: the same opening in another game, or two opening book lines that shot the same cells in a different order. Once a ship
+ * sank, the grid and the heaps depend on the order of the shots (RetireSunkShip() only refreshes the cells around the ship), so results
+ * read from them are not cached.
+ *
+ * The knowledge is summarised by a 64-bit Zobrist hash, player->knowledgeHash: the XOR of one key per resolved cell (and its content) and
+ * one key per (length, ships afloat) pair. HitCell() and RegisterShipHit() XOR the keys of what changed in and out, so the hash costs O(1)
+ * per shot, and it does not depend on the order of the shots.
+ *
+ * The transposition cache maps a knowledge hash and a query to 64 bits of result. It is a table of TRANSPOSITION_ENTRIES slots shared by
+ * every game of the process, where a result replaces whatever was in its slot. Slots are read and written without locks: a slot keeps its
+ * key XORed with its data, so a slot torn by two threads writing it at once fails the check and reads as a miss.
+ *
+ * Players with a placement prior are never cached, since their probabilities also depend on their profile.
+ */
+
+#ifndef TRANSPOSITION_ENTRIES
+#define TRANSPOSITION_ENTRIES (1 << 16) //Must be a power of 2.
+#endif
+
+typedef enum TranspositionQuery{
+    TT_HUNT_OFFSET,     //Hunt lattice offset picked for a stride (argument: the stride). Data: the offset.
+    TT_OPENING_CUTOFF,  //Opening book candidates (argument: OPENINGBOOK_CANDIDATE_PERCENT). Data: the cutoff and the candidate count.
+    TRANSPOSITIONQUERYCOUNT
+} TranspositionQuery;
+
+/**
+ * SplitMix64 finalizer: spreads any index over 64 bits, so the Zobrist keys don't need a table.
+ */
+static inline unsigned long long ZobristKey(unsigned long long index){
+
+    unsigned long long z = index + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline unsigned long long ZobristCellKey(int row, int col, char state){
+
+    return ZobristKey(((unsigned long long)(row * GRIDSIZE + col) << 1) | (state == HIT));
+}
+
+static inline unsigned long long ZobristFleetKey(int length, int afloat){
+
+    return ZobristKey(((unsigned long long)length << 40) ^ ((unsigned long long)afloat << 20) ^ 0xF1EE7ULL);
+}
+
+unsigned long long InitialKnowledgeHash(Fleet * fleet);
+
+int ProbeTransposition(Player * player, TranspositionQuery query, int argument, unsigned long long * data);
+void StoreTransposition(Player * player, TranspositionQuery query, int argument, unsigned long long data);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef WEAPONS
+#define WEAPONS
+
+#include <stdbool.h>
+
+typedef struct Player Player;
+
+/**
+ * Every weapon of the game is described by an entry in the WeaponTable instead of its own hand-written loop. The entry holds the footprint,
+ * what the weapon does to the cells it covers, how much ammo it has and when it unlocks. ApplyWeapon() is the only kernel that runs them,
+ * so a new weapon variant only needs a new entry.
+ */
+
+typedef enum WeaponID{
+    WEAPON_FIRE, WEAPON_RADAR, WEAPON_SMOKE, WEAPON_ARTILLERY, WEAPON_TORPEDO, WEAPONCOUNT
+} WeaponID;
+
+typedef enum WeaponShape{
+    SHAPE_STENCIL,  //The footprint is a stencil anchored at the targeted cell (top left corner).
+    SHAPE_LINE      //The footprint is an entire row or column of the grid.
+} WeaponShape;
+
+typedef enum WeaponEffect{
+    EFFECT_HIT,     //Hits the ship cells under the footprint and marks the rest as misses in easy mode.
+    EFFECT_REVEAL,  //Reports whether any unsmoked ship cell lies under the footprint.
+    EFFECT_SMOKE    //Hides the attacker's own cells under the footprint from radars.
+} WeaponEffect;
+
+typedef enum WeaponAmmo{
+    AMMO_UNLIMITED,
+    AMMO_FIXED,         //The weapon can be used ammo times per game.
+    AMMO_PER_SUNK_SHIP  //The weapon can be used once for every ship the attacker sunk.
+} WeaponAmmo;
+
+typedef enum WeaponUnlock{
+    UNLOCK_ALWAYS,
+    UNLOCK_AFTER_SINKING //The weapon can only be used in the turn right after sinking a ship (and after minOpponentSunk ships are sunk).
+} WeaponUnlock;
+
+/**
+ * Stencils are bitmasks of up to STENCIL_SIZE x STENCIL_SIZE cells. Bit (i * STENCIL_SIZE + j) covers the cell i rows below and j columns to
+ * the right of the targeted cell. A stencil of 0 means the footprint is the full height x width rectangle, which gets the fast paths.
+ */
+#define STENCIL_SIZE 8
+#define STENCIL_BIT(i, j) (1ULL << ((i) * STENCIL_SIZE + (j)))
+#define STENCIL_RECT 0ULL
+
+typedef struct WeaponDef{
+
+    char * name;
+
+    WeaponShape shape;
+    int height;
+    int width;
+    unsigned long long stencil;
+
+    WeaponEffect effect;
+
+    WeaponAmmo ammoType;
+    int ammo;
+
+    WeaponUnlock unlock;
+    int minOpponentSunk;
+
+    bool rejectRepeatedHit; //Single cell weapons refuse to shoot a cell that was already hit.
+
+    char * lockedMsg;
+    int lockedLosesTurn;    //If 1, trying to use the weapon while locked still ends the turn.
+
+    char * missMsg;
+
+} WeaponDef;
+
+extern WeaponDef WeaponTable[WEAPONCOUNT];
+
+int CanUseWeapon(WeaponID weaponID, Player * attacker, Player * target);
+
+int ApplyWeapon(WeaponID weaponID, Player * attacker, Player * target, int row, int col, int difficulty, char ** outputMsg);
+
+#endif
@@ -1,12 +1,20 @@
 #ifndef DEFS
 #define DEFS
 
+/**
+ * Can be overridden at compile time (-DGRIDSIZE=N). The bench target uses this to build the engine at several grid sizes.
+ */
+#ifndef GRIDSIZE
 #define GRIDSIZE 200
+#endif
 
 #define WATER_C '~'
 
+/**
+ * The classic fleet. Games use it unless SetGameFleet() is given another one (large boards typically need 20 to 50 ships).
+ */
 #define SHIPCOUNT 4
-#define SHIPSIZES {2,3,4,5}
+#define SHIPSIZES {CARRIER_LENGTH, BATTLESHIP_LENGTH, DESTROYER_LENGTH, SUBMARINE_LENGTH}
 
 #define SUBMARINE_C 's'
 #define DESTROYER_C 'd'
@@ -14,24 +22,51 @@
 #define CARRIER_C 'c'
 #define HIT 'x'
 #define MISS 'O'
+#define SHIP_C '#' //Ships whose length is not one of the classic four
+
+/**
+ * Ship IDs are stored in the player's shipIdGrid. Unlike ship chars, they survive a cell being overwritten by HIT.
+ * Ship i of the game fleet has ID i + 1, so in the classic fleet the IDs below are kept.
+ */
+#define NOSHIP_ID 0
+#define CARRIER_ID 1
+#define BATTLESHIP_ID 2
+#define DESTROYER_ID 3
+#define SUBMARINE_ID 4
 
-#define IsShip(c) (c == CARRIER_C || c == BATTLESHIP_C || c == DESTROYER_C || c == SUBMARINE_C)
+#define MAXSHIPCOUNT 255 //The shipIdGrid stores IDs in unsigned chars and 0 is NOSHIP_ID
+
+#define IsShip(c) (c == CARRIER_C || c == BATTLESHIP_C || c == DESTROYER_C || c == SUBMARINE_C || c == SHIP_C)
 
 #define SUBMARINE_LENGTH 2
 #define DESTROYER_LENGTH 3
 #define BATTLESHIP_LENGTH 4
 #define CARRIER_LENGTH 5
 
-#define LONGEST_SHIPLENGTH CARRIER_LENGTH
+/**
+ * The fleet every player of the current game gets: GameShipLengths[i] is the length of the ship of ID i + 1.
+ */
+extern int GameShipCount;
+extern int GameShipLengths[MAXSHIPCOUNT];
+
+/**
+ * Weapon footprints (height x width in cells). The radar uses the player's summed-area table so its cost does not depend on its size.
+ */
+#define RADAR_HEIGHT 2
+#define RADAR_WIDTH 2
+#define SMOKE_HEIGHT 2
+#define SMOKE_WIDTH 2
+#define ARTILLERY_HEIGHT 2
+#define ARTILLERY_WIDTH 2
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
-#define GAMEMODECOUNT 2
+#define GAMEMODECOUNT 3
 
-typedef enum GameMode{ INVALIDMODE = -1, PVP, PVE }GameMode;
+typedef enum GameMode{ INVALIDMODE = -1, PVP, PVE, FFA }GameMode;
 
-extern char* GameModeStrings[2];
+extern char* GameModeStrings[GAMEMODECOUNT];
 
 #define DIFFICULTYCOUNT 2
 extern char* DifficultyStrings[2];
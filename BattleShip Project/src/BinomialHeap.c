@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "../include/BinomialHeap.h"
+#include "../include/Metrics.h"
+#include "../include/Memory.h"
 
 
 /**
@@ -20,7 +22,7 @@ BinomialHeap * ConstructBinomialHeap(void ** array, int arrayLen, int (*compare)
 
     if (compare == NULL) return NULL;
 
-    BinomialHeap * heap = (BinomialHeap *)(malloc(sizeof(BinomialHeap)));
+    BinomialHeap * heap = (BinomialHeap *)(alloc_Tracked(MEM_HEAPS, sizeof(BinomialHeap)));
 
     heap->head = NULL;
 
@@ -52,8 +54,11 @@ BinomialHeap * ConstructBinomialHeap(void ** array, int arrayLen, int (*compare)
  */
 int insert(BinomialHeap * binomHeap, void * data){
 
+    METRIC_COUNT(COUNTER_HEAP_INSERTS);
+    METRIC_COUNT(COUNTER_ALLOCATIONS);
+
     if (binomHeap->head == NULL){
-        binomHeap->head = (Node *)(malloc(sizeof(Node)));
+        binomHeap->head = (Node *)(alloc_Tracked(MEM_HEAPS, sizeof(Node)));
         binomHeap->head->degree = 0;
         binomHeap->head->leftChild = NULL;
         binomHeap->head->parent = NULL;
@@ -62,7 +67,7 @@ int insert(BinomialHeap * binomHeap, void * data){
     }
     else {
 
-        Node * newNode = (Node *)(malloc(sizeof(Node)));
+        Node * newNode = (Node *)(alloc_Tracked(MEM_HEAPS, sizeof(Node)));
         newNode->parent = NULL;
         newNode->leftChild = NULL;
         newNode->rightSibling = binomHeap->head;
@@ -341,6 +346,8 @@ void* deleteMin(BinomialHeap * heap){
 
     if (curr == NULL) return NULL;
 
+    METRIC_COUNT(COUNTER_HEAP_DELETES);
+
     //Find the min:
     while (curr != NULL)
     {
@@ -371,7 +378,7 @@ void* deleteMin(BinomialHeap * heap){
 
     void* res = minNode->value;
 
-    free(minNode);
+    FreeTracked(minNode);
 
     return res;
 
@@ -401,19 +408,62 @@ int deleteMinInt(BinomialHeap * heap){
 
 BinomialHeap * ConstructIntBinomialHeap(int* array, int arrayLen, int (*compare)(void*, void*)){
 
-    void** voidArr = (void**)(malloc(sizeof(void*) * arrayLen));
+    void** voidArr = (void**)(alloc_Tracked(MEM_HEAPS, sizeof(void*) * arrayLen));
 
     for (int i = 0; i < arrayLen; i++)
     {
-        int * ptr = (int*)(malloc(sizeof(int)));
+        int * ptr = (int*)(alloc_Tracked(MEM_HEAPS, sizeof(int)));
         *ptr = array[i];
 
         voidArr[i] = (void*)ptr;
     }
     
 
-    return ConstructBinomialHeap(voidArr, arrayLen, compare);
+    BinomialHeap * heap = ConstructBinomialHeap(voidArr, arrayLen, compare);
+
+    FreeTracked(voidArr);
+
+    return heap;
+
+}
+
+/**
+ * Frees every node of a tree and of its right siblings. The recursion goes as deep as the number of trees plus the height, both O(logn).
+ */
+static void FreeHeapNodes(Node * node, void (*freeValue)(void*)){
+
+    while (node != NULL)
+    {
+        Node * next = node->rightSibling;
+
+        FreeHeapNodes(node->leftChild, freeValue);
+
+        if (freeValue != NULL) freeValue(node->value);
+        FreeTracked(node);
+
+        node = next;
+    }
+}
+
+/**
+ * Empties the heap in O(n) without the unions deleteMin() would do. freeValue is called on every value the heap still holds (NULL keeps
+ * them). The heap itself stays usable.
+ */
+void ClearBinomialHeap(BinomialHeap * heap, void (*freeValue)(void*)){
+
+    if (heap == NULL) return;
+
+    FreeHeapNodes(heap->head, freeValue);
+    heap->head = NULL;
+}
+
+/**
+ * Clears a heap made by ConstructBinomialHeap() and frees it.
+ */
+void FreeBinomialHeap(BinomialHeap * heap, void (*freeValue)(void*)){
 
+    ClearBinomialHeap(heap, freeValue);
+    FreeTracked(heap);
 }
 
 
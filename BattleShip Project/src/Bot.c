@@ -3,6 +3,10 @@
 #include "../include/Player.h"
 #include "../include/ShipPlacement.h"
 #include "../include/CalcProbs.h"
+#include "../include/Metrics.h"
+#include "../include/Trace.h"
+#include "../include/Memory.h"
+#include "../include/OpeningBook.h"
 
 #include <time.h>
 
@@ -81,12 +85,25 @@
 
 
 
+static int CountCategorizedRegions(Player * opponent){
+
+    int count = 0;
+    for (int i = 0; i < PROB_CATEGORYCOUNT; i++) count += opponent->probabilityHeapCategoryLists[i].size;
+
+    return count;
+}
+
 void BotSmartAttack(Player * bot, Player * opponent){
 
+    TRACE_SCOPE("BotSmartAttack");
+
+    //The opponent may have no probabilities yet, or still share the starting ones of its configuration. The bot's shots need its own:
+    AcquireProbabilityState(opponent);
+
     start:
 
     //First we must check if the stack is empty:
-    if (is_empty(bot->stackMemory)){
+    if (IsTaskQueueEmpty(&bot->stackMemory)){
 
         //printf("stack empty, continuing pattern: \n");
 
@@ -97,16 +114,28 @@ void BotSmartAttack(Player * bot, Player * opponent){
         int row = 0;
         int col = 0;
 
+        METRIC_TIMER_START(selectionStart);
 
-        if (bot->riskFactor < HIGH_RISK){
+        selectTarget:
+
+        //Once every cell of the hunt lattice was shot, what is left to find are ships that were hit but not sunk:
+        if (CountCategorizedRegions(opponent) == 0) WidenHuntLattice(opponent);
+
+        if (NextOpeningShot(bot, opponent, &row, &col) > 0){
+            //Still in the opening book, the shot is a lookup.
+        }
+        else if (bot->riskFactor < HIGH_RISK){
 
             int count = 0;
             while (opponent->probabilityHeapCategoryLists[bot->currTargetCategory].size == 0)
             {
                 if (count >= PROB_CATEGORYCOUNT){
-                    //Something is definetely going wrong, all lists appear empty!
-                    perror("Something is wrong! All probability categories are empty.");
-                    exit(EXIT_FAILURE);
+                    //Every heap was emptied while ships are left, their last cells dropped to a probability of 0 (other players in a
+                    //free-for-all game may have resolved most of the grid). The bot falls back to the most probable cell left:
+                    GetHighestUnresolvedCell(&row, &col, opponent);
+                    METRIC_TIMER_STOP(TIMER_BOT_TARGET_SELECTION, selectionStart);
+                    BotFireHelper(row, col, bot, opponent);
+                    return;
                 }
 
                 bot->currTargetCategory += 1;
@@ -115,14 +144,20 @@ void BotSmartAttack(Player * bot, Player * opponent){
             }
             
             
-            pickCoords:
             //Get a randome cell from the opponent's category list of index bot->currTargetCategory:
             int getCoord = GetRandomProbCoordinateFromCategory(&row, &col, &opponent->probabilityHeapCategoryLists[bot->currTargetCategory]);
             //printf("got random coord %d,%d\n", row, col);
             //printf("getCoord: %d\n", getCoord);
 
+            //On lazy boards the picked region may only hold an estimate. Once refined it can change category, so the pick starts over:
+            if (RefineRegion(opponent, HashRegion(row, col)) > 0){
+                goto selectTarget;
+            }
+
+            //A resolved top means the region's heap missed an update, it is rebuilt from the grid before picking again:
             if (opponent->grid[row][col] == HIT || (opponent->grid[row][col] == MISS)){
-                goto pickCoords;
+                UpdateHeap(opponent, HashRegion(row, col));
+                goto selectTarget;
             }
 
             bot->currTargetCategory += 1;
@@ -130,14 +165,12 @@ void BotSmartAttack(Player * bot, Player * opponent){
 
         }
         else {
-            if (bot->riskFactor == EXTREMELYHIGH_RISK){
-                GetHighestProbability(&row, &col, opponent);
-            }
-            else {
-                GetRandomHighestProbCell(&row, &col, opponent);
-            }
+            int getCell = (bot->riskFactor == EXTREMELYHIGH_RISK) ? GetHighestProbability(&row, &col, opponent) : GetRandomHighestProbCell(&row, &col, opponent);
+
+            if (getCell < 0) GetHighestUnresolvedCell(&row, &col, opponent);
         }
 
+        METRIC_TIMER_STOP(TIMER_BOT_TARGET_SELECTION, selectionStart);
 
         //Now I must attack the target:
         #pragma region [Firing]
@@ -151,7 +184,7 @@ void BotSmartAttack(Player * bot, Player * opponent){
         int fire = BotFireHelper(row, col, bot, opponent);
 
 
-        if (error != NULL) free(error);
+        if (error != NULL) FreeTracked(error);
 
 
         #pragma endregion
@@ -169,26 +202,94 @@ void BotSmartAttack(Player * bot, Player * opponent){
 
         doTask:
 
-        if (is_empty(bot->stackMemory)){
+        BotTask topTask;
+
+        if (!GetNextTask(bot, &topTask)){
             goto start;
-        }  
+        }
 
+        METRIC_TIMER_START(taskStart);
 
-        BotTask * topTask = (BotTask*)removeFirst(bot->stackMemory);
-        //printf("get funcptr: %p\n", topTask->function);
-        int res = PerformTask(topTask);
+        int res = PerformTask(bot, &topTask);
 
         //if res = 0 then the task was either invalid or 
 
         if (res <= 0){
-            freeTask(topTask);
+            METRIC_TIMER_STOP(TIMER_BOT_TASK_PROCESSING, taskStart);
             goto doTask;
         }
 
+        METRIC_TIMER_STOP(TIMER_BOT_TASK_PROCESSING, taskStart);
+
     }
 }
 
 
+#pragma region [Target Selection]
+
+/**
+ * In games with more than two players, the bot picks which opponent to attack this turn.
+ * 
+ * A bot in the middle of sinking a ship (tasks left on its stack) keeps going after the same player. Tasks aimed at players who were
+ * eliminated in the meantime, or at cells that can no longer hold a ship (see IsTargetCellPossible()), are dropped. Otherwise the bot attacks the opponent with the highest expected hit chance (see
+ * ExpectedHitChance()), and when two opponents are equal it goes for the one with fewer ships left, since eliminating a player
+ * means one less player shooting back.
+ * 
+ * Returns the index of the target in players, or -1 if no opponent is alive.
+ */
+int BotPickTarget(Player * bot, Player ** players, int playerCount){
+
+    METRIC_TIMER_START(selectionStart);
+
+    BotTask * task;
+
+    while ((task = PeekTask(&bot->stackMemory)) != NULL)
+    {
+        Player * target = task->target;
+
+        if (task->kind == TASK_FIRE && IsPlayerAlive(target) && IsTargetCellPossible(target, task->row, task->col)){
+            for (int i = 0; i < playerCount; i++)
+            {
+                if (players[i] == target){
+                    METRIC_TIMER_STOP(TIMER_BOT_OPPONENT_SELECTION, selectionStart);
+                    return i;
+                }
+            }
+            break;
+        }
+
+        //The target is out of the game, or the cell can no longer hold a ship:
+        BotTask dropped;
+        if (!GetNextTask(bot, &dropped)) break;
+    }
+
+    int best = -1;
+    double bestChance = -1;
+
+    for (int i = 0; i < playerCount; i++)
+    {
+        Player * target = players[i];
+
+        if (target == bot || target == NULL || !IsPlayerAlive(target)) continue;
+
+        double chance = ExpectedHitChance(bot, target);
+        int shipsLeft = target->fleet.shipCount - countSunkShips(target);
+
+        if (best < 0 || chance > bestChance
+         || (chance == bestChance && shipsLeft < players[best]->fleet.shipCount - countSunkShips(players[best]))){
+            best = i;
+            bestChance = chance;
+        }
+    }
+
+    METRIC_TIMER_STOP(TIMER_BOT_OPPONENT_SELECTION, selectionStart);
+
+    return best;
+}
+
+#pragma endregion
+
+
 #pragma region [Accessing Probability Cells]
 /**
  * Input:
@@ -215,7 +316,6 @@ int GetRandomProbCoordinateFromCategory(int * row, int * col, D_LinkedList * hea
         return -1;
     }
 
-    srand(time(0));
     int randIndex = rand() % heapCategory->size;
 
     D_ListNode * curr = get_first(heapCategory);
@@ -226,13 +326,10 @@ int GetRandomProbCoordinateFromCategory(int * row, int * col, D_LinkedList * hea
     }
     
 
-    int * elem = BinHeap_FindHighestProbabilityCell((BinomialHeap*)(curr->data));
+    int top = ((ProbabilityHeap*)(curr->data))->top;
 
-    //printf("max prob in heap: %d\n", ((int*)elem)[0]);
-    //printf("hmm: %d\n", *(int*)(heapCategory[randIndex]->head->rightSibling->value));
-
-    *row = elem[1];
-    *col = elem[2];
+    *row = top / GRIDSIZE;
+    *col = top % GRIDSIZE;
 
     return 1;
 
@@ -246,6 +343,8 @@ int GetRandomProbCoordinateFromCategory(int * row, int * col, D_LinkedList * hea
  */
 int GetRandomHighestProbCell(int * row, int* col, Player * player){
 
+    pick:
+
     //First we check if the high-probability category contains anything:
     if (player->probabilityHeapCategoryLists[2].size > 0){
         GetRandomProbCoordinateFromCategory(row, col, &player->probabilityHeapCategoryLists[2]);
@@ -261,6 +360,9 @@ int GetRandomHighestProbCell(int * row, int* col, Player * player){
         return -1;
     }
 
+    //A stale region of a lazy board is refined and the pick starts over (see BotSmartAttack()):
+    if (RefineRegion(player, HashRegion(*row, *col)) > 0) goto pick;
+
     return 1;
 }
 
@@ -287,19 +389,21 @@ int GetHighestProbCoordinateFromCategory(int * row, int * col, D_LinkedList * he
 
     int highestIndex = 0;
 
-    //Recall, we're working with linked lists of binomial heaps, so the D_ListNode stores a binomial heap struct pointer as data.
+    //Recall, we're working with linked lists of heaps, so the D_ListNode stores a ProbabilityHeap struct pointer as data.
 
     D_ListNode * curr = get_first(heapCategory);
     D_ListNode * maxProbNode = curr;
 
     while (curr != NULL)
     {
-        int currProb = BinHeap_FindHighestProbabilityCell((BinomialHeap*)(curr->data))[0];
-        int maxProb = BinHeap_FindHighestProbabilityCell((BinomialHeap*)(maxProbNode->data))[0];
+        int currProb = ((ProbabilityHeap*)(curr->data))->topProbability;
+        int maxProb = ((ProbabilityHeap*)(maxProbNode->data))->topProbability;
         
         if (currProb > maxProb){
             maxProbNode = curr;
         }
+
+        curr = curr->next;
     }
 
     if (maxProbNode == NULL){
@@ -307,10 +411,10 @@ int GetHighestProbCoordinateFromCategory(int * row, int * col, D_LinkedList * he
         return -1;
     }
 
-    int * res = BinHeap_FindHighestProbabilityCell((BinomialHeap*)(maxProbNode->data));
+    int top = ((ProbabilityHeap*)(maxProbNode->data))->top;
 
-    *row = res[1];
-    *col = res[2];
+    *row = top / GRIDSIZE;
+    *col = top % GRIDSIZE;
 
     return 1;
     
@@ -322,6 +426,8 @@ int GetHighestProbCoordinateFromCategory(int * row, int * col, D_LinkedList * he
  */
 int GetHighestProbability(int * row, int* col, Player * player){
 
+    pick:
+
     //First we check if the high-probability category contains anything:
     if (player->probabilityHeapCategoryLists[2].size > 0){
         GetHighestProbCoordinateFromCategory(row, col, &player->probabilityHeapCategoryLists[2]);
@@ -330,20 +436,52 @@ int GetHighestProbability(int * row, int* col, Player * player){
         GetHighestProbCoordinateFromCategory(row, col, &player->probabilityHeapCategoryLists[1]);
     }
     else if (player->probabilityHeapCategoryLists[0].size > 0){
-        GetHighestProbCoordinateFromCategory(row, col, &player->probabilityHeapCategoryLists[2]);
+        GetHighestProbCoordinateFromCategory(row, col, &player->probabilityHeapCategoryLists[0]);
     }
     else {
         printf("Something must have gone wrong. All grid cells have 0 probability.\n");
         return -1;
     }
 
+    //The best heap of a lazy board may only hold an estimate, it is refined and compared again:
+    if (RefineRegion(player, HashRegion(*row, *col)) > 0) goto pick;
+
     return 1;
 }
 
+/**
+ * Scans the whole grid for the unresolved cell with the highest probability and saves its coordinate values in row and col. This is the
+ * fallback for when every heap was emptied while ships are left. Returns -1 if every cell is resolved.
+ */
+int GetHighestUnresolvedCell(int * row, int * col, Player * player){
+
+    //The whole grid is read:
+    RefineProbabilities(player);
+
+    int found = -1;
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            if (player->grid[i][j] == HIT || player->grid[i][j] == MISS) continue;
+
+            if (found < 0 || player->probabilityGrid[i][j] > player->probabilityGrid[*row][*col]){
+                *row = i;
+                *col = j;
+                found = 1;
+            }
+        }
+    }
+
+    return found;
+}
+
 #pragma endregion
 
 /**
- * This function updates a specified binomial heap by updating each element's probability and re-inserting it into the heap.
+ * This function updates a specified heap by updating each cell's probability and re-inserting it into the heap, then moves the heap to
+ * the category of its new highest probability.
  * 
  * Input:
  *      - player: the player of which a heap will be updated
@@ -351,98 +489,34 @@ int GetHighestProbability(int * row, int* col, Player * player){
  */
 int UpdateHeap(Player * player, int heapIndex){
 
-    //printf("\nINSIDE UPDATEHEAP FUNC:\n");
+    TRACE_SCOPE("UpdateHeap");
 
     if (heapIndex >= PROB_REGION_COUNT || heapIndex < 0) return -1;
 
-    //printf("is it null: %d\n", player->probabilityHeapSet[heapIndex] == NULL);
-
-    //First I need to intialize a temporary binomial heap:
-    BinomialHeap temp;
-    temp.head = NULL;
-    temp.compare = player->probabilityHeapSet[heapIndex]->compare;
-    
-    //printf("heree!\n");
-
-    BinomialHeap * targetHeap = player->probabilityHeapSet[heapIndex];
+    //A stale region is rebuilt from its cells rather than from the grid (RefineRegion() calls back once the region is up to date):
+    if (RefineRegion(player, heapIndex) > 0) return 1;
 
+    ProbabilityHeap * targetHeap = &player->probabilityHeapSet[heapIndex];
 
-    while (targetHeap->head != NULL)
-    {
-        int * element = (int*)deleteMin(targetHeap);
-
-        int row = element[1];
-        int col = element[2];
-
-        //Updating the probability to the new one after probGrid got updated:
-        element[0] = player->probabilityGrid[row][col];
-
-        //Now I need to make sure that the probability is not 0 and the coordinate is neither a hit nor a miss:
-        if (element[0] > 0 && player->grid[row][col] != MISS && player->grid[row][col] != HIT){
-            insert(&temp, element);
-        }
-    }
-    
-    //Connect the head of the temporary heap to the initial, now empty, heap:
-    targetHeap->head = temp.head;
+    //A region holds at most PROB_REGION_WIDTH * PROB_REGION_HEIGHT cells, so they fit on the stack while the heap is rebuilt in place:
+    int cells[PROB_REGION_WIDTH * PROB_REGION_HEIGHT];
+    int cellCount = ProbabilityHeapCells(player->probabilityNodes, targetHeap, cells);
 
-    //NOT ENOUGH TIME TO THINK OF AND IMPLEMENT A BETTER WAY THAN THE ONE BELOW.
+    ClearProbabilityHeap(targetHeap);
 
-    //Finally, I must move this heap to the right category:
-    //I'll traverse all the categories till I find this heap:
-    D_ListNode * curr = NULL; 
-    int CategoryNumber = 0;
-    while (CategoryNumber < PROB_CATEGORYCOUNT)
+    for (int k = 0; k < cellCount; k++)
     {
-        curr = get_first(&player->probabilityHeapCategoryLists[CategoryNumber]);
-        while (curr != NULL)
-        {
-            BinomialHeap * currHeap = (BinomialHeap*)(curr->data);
+        int row = cells[k] / GRIDSIZE;
+        int col = cells[k] % GRIDSIZE;
 
-            int row = ((int*)(currHeap->head->value))[1];
-            int col = ((int*)(currHeap->head->value))[2];
-
-            if (HashRegion(row, col) == heapIndex){//We don't compare the nodes because they are not the same
-                int currHeapProb = BinHeap_FindHighestProbabilityCell(targetHeap)[0];
-                if ((currHeapProb >= HIGHPROB_BASE && CategoryNumber == 2) || (currHeapProb >= AVGPROB_BASE && CategoryNumber == 1)
-                 || (currHeapProb >= LOWPROB_BASE && CategoryNumber == 0)){
-                    return 1; //This means that the heap is at the right location.
-                 }
-
-                goto endLoop;
-            }
-
-            curr = curr->next;
+        //Now I need to make sure that the probability is not 0 and the coordinate is neither a hit nor a miss. Other cells leave the heaps for good:
+        if (player->probabilityGrid[row][col] > 0 && player->grid[row][col] != MISS && player->grid[row][col] != HIT && IsHuntCell(player, row, col)){
+            ProbabilityHeapInsert(player->probabilityNodes, targetHeap, cells[k], player->probabilityGrid[row][col]);
         }
-        CategoryNumber++;
     }
-    endLoop:
-
-    if (curr == NULL || CategoryNumber >= PROB_CATEGORYCOUNT){
-        printf("Something is wrong, cannot find heap in any category!");
-        return -1;
-    }
-
-    disconnectNode(&player->probabilityHeapCategoryLists[CategoryNumber], curr);
 
-    int highestProb = BinHeap_FindHighestProbabilityCell(targetHeap)[0];
-
-        //InOrderTraversal_ProbNode_Print(&binHeap);
-    //printf("highestProb: %d\n", highestProb);
-
-    if (highestProb >= HIGHPROB_BASE){
-
-        //Place in list of index 2 for high probabilities:
-        addLast(&player->probabilityHeapCategoryLists[2], targetHeap);
-    }
-    else if (highestProb >= AVGPROB_BASE){
-        //Place in array of index 1 for avg probabilities:
-        addLast(&player->probabilityHeapCategoryLists[1], targetHeap);
-    }
-    else {
-        //Place in array of index 0 for low probabilities:
-        addLast(&player->probabilityHeapCategoryLists[0], targetHeap);
-    }
+    //Finally, I must move this heap to the right category (an emptied region has nothing left to target, so it leaves its category for good):
+    FileProbabilityHeap(player, heapIndex);
 
     return 1;
 }
@@ -453,6 +527,8 @@ int UpdateHeap(Player * player, int heapIndex){
  */
 int UpdateHeapsWithinBounds(Player * player, int row0, int row1, int col0, int col1){
 
+    TRACE_SCOPE("UpdateHeapsWithinBounds");
+
     //I could keep track of every region I've already updated so that I don't update it again.
     //But I don't see no easy way of doing that without using a data structure
     //Or, better way: I could save the hash indices of the regions updated and check if the array contains the one I'm trying to update
@@ -462,107 +538,292 @@ int UpdateHeapsWithinBounds(Player * player, int row0, int row1, int col0, int c
     //in the horizontal direction and update until it goes out of bounds of the target area.
     //I do the same vertically.
 
-    int curr[2] = {row0, col0};
+    //On lazy boards the probability updates already marked these regions stale, they are rebuilt when a query reaches them:
+    if (player->staleRegions != NULL) return 1;
 
     int regionSize[2] = PROB_REGION_SIZE;
 
-    
-    while (IndexWithinRange(curr[0])){
+    row0 = MAX(0, row0);
+    col0 = MAX(0, col0);
+    row1 = MIN(GRIDSIZE - 1, row1);
+    col1 = MIN(GRIDSIZE - 1, col1);
+
+    //The point starts at the origin of the region containing (row0, col0) and jumps exactly one region at a time, so every region
+    //intersecting the area is updated once and the area bounds are respected.
+    int curr[2] = {row0 - (row0 % regionSize[0]), col0 - (col0 % regionSize[1])};
+
+    while (curr[0] <= row1){
+
+        curr[1] = col0 - (col0 % regionSize[1]);
 
-        while (IndexWithinRange(curr[0]) && IndexWithinRange(curr[1])){
+        while (curr[1] <= col1){
             
             UpdateHeap(player, HashRegion(curr[0], curr[1]));
 
-            curr[1] += regionSize[1] + 1;
+            curr[1] += regionSize[1];
         }
-        curr[1] = col0;
-        curr[0] += regionSize[0] + 1;
+        curr[0] += regionSize[0];
 
     }
-        
 
+    return 1;
 }
 
+/**
+ * Brings the target's probabilities and region heaps up to date after one of its cells was resolved. It is called by the weapons for
+ * every cell they resolve (see HitCell() in Weapons.c), so a human's shot in a free-for-all game updates them like a bot's. sunkShipID is
+ * the ship the shot sank, or NOSHIP_ID.
+ */
+void UpdateShotProbabilities(Player * target, int row, int col, int sunkShipID){
+
+    //A player with no probability state of its own (see AcquireProbabilityState()) gets one from its grid when a bot first targets it:
+    if (target->probabilityHeapSet == NULL) return;
 
+    TRACE_SCOPE("UpdateShotProbabilities");
 
+    int cell[2] = {row, col};
 
+    //Updating the probability distribution:
+    METRIC_TIMER_START(probabilityStart);
+    UpdateSurroundingProbabilities(target, cell);
+    METRIC_TIMER_STOP(TIMER_BOT_PROBABILITY_UPDATE, probabilityStart);
 
+    //Update the probability heaps for all the probability regions that surround the cell.
+    int reach = target->fleet.maxLength;
+
+    METRIC_TIMER_START(heapStart);
+    UpdateHeapsWithinBounds(target, MAX(0, row - reach), MIN(GRIDSIZE, row + reach),
+     MAX(0, col - reach), MIN(GRIDSIZE, col + reach));
+    METRIC_TIMER_STOP(TIMER_BOT_HEAP_REFRESH, heapStart);
+
+    if (sunkShipID == NOSHIP_ID) return;
+
+    //The shipIdGrid told the weapon which ship sank, so the probability engine can retire its length right away:
+    Fleet * fleet = &target->fleet;
+
+    METRIC_TIMER_START(retireStart);
+    RetireSunkShip(target, sunkShipID);
+    METRIC_TIMER_STOP(TIMER_BOT_PROBABILITY_UPDATE, retireStart);
+
+    //When the smallest length is gone, the heaps are rebuilt on a wider lattice, otherwise only the regions around the ship changed:
+    METRIC_TIMER_START(sunkHeapStart);
+    if (UpdateHuntLattice(target) == 0){
+        UpdateHeapsWithinBounds(target, fleet->startRow[sunkShipID] - reach, fleet->endRow[sunkShipID] + reach,
+         fleet->startCol[sunkShipID] - reach, fleet->endCol[sunkShipID] + reach);
+    }
+    METRIC_TIMER_STOP(TIMER_BOT_HEAP_REFRESH, sunkHeapStart);
+}
+
+
+
+
+
+
+#pragma region [Task Queue]
 
 /**
- * This function assigns a new task. It creates a new task structure, fills it with a pointer to the function it must perform and with the arguments
- * necessary. It then pushes the new task onto the bot's stack memory.
+ * Allocates room for capacity tasks (rounded up to a power of 2). A capacity of 0 leaves the queue empty without a buffer, the first task
+ * queued allocates it.
  */
-BotTask * CreateTask(int (*function)(void**), void** arguments, int argumentCount, void** flags, int flagCount){
+int InitializeTaskQueue(BotTaskQueue * queue, int capacity){
+
+    queue->tasks = NULL;
+    queue->capacity = 0;
+    queue->head = 0;
+    queue->count = 0;
+
+    for (int i = 0; i < TASKQUEUE_BOARDS; i++)
+    {
+        queue->queuedBoards[i] = NULL;
+        queue->queued[i] = NULL;
+    }
 
-    BotTask * task = (BotTask*)(malloc(sizeof(BotTask)));
+    if (capacity <= 0) return 1;
 
-    //printf("creat funcptr: %p\n", function);
+    int rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
 
-    task->function = function;
-    task->arguments = arguments;
-    task->argumentCount = argumentCount;
-    task->flags = flags;
-    task->flagCount = flagCount;
+    queue->tasks = (BotTask*)(alloc_Tracked(MEM_TASKS, sizeof(BotTask) * rounded));
+    if (queue->tasks == NULL) return 0;
 
+    queue->capacity = rounded;
+    METRIC_COUNT(COUNTER_ALLOCATIONS);
 
+    return 1;
 }
 
-int freeTask(BotTask * task){
+/**
+ * Returns the queued cells bitset of the board, allocating it if the board has none yet and create is set. Returns NULL if the board has
+ * none, or if every slot is taken: its tasks are then queued without deduplication.
+ */
+static unsigned char * QueuedCellsOfBoard(BotTaskQueue * queue, Player * board, int create){
 
-    if (task->arguments != NULL){
-        for (int i = 0; i < task->argumentCount; i++)
-        {
-            free(task->arguments[i]);
-        }
-    }
+    int freeSlot = -1;
 
-    if (task->flags != NULL){
-        for (int i = 0; i < task->flagCount; i++)
-        {
-            free(task->flags[i]);
-        }
-        
+    for (int i = 0; i < TASKQUEUE_BOARDS; i++)
+    {
+        if (queue->queuedBoards[i] == board) return queue->queued[i];
+        if (queue->queuedBoards[i] == NULL && freeSlot < 0) freeSlot = i;
     }
 
-    free(task);    
+    if (!create || freeSlot < 0) return NULL;
 
+    queue->queued[freeSlot] = (unsigned char*)(alloc_TrackedZeroed(MEM_TASKS, (GRIDSIZE * GRIDSIZE + 7) / 8, sizeof(unsigned char)));
+    if (queue->queued[freeSlot] == NULL) return NULL;
+
+    METRIC_COUNT(COUNTER_ALLOCATIONS);
+
+    queue->queuedBoards[freeSlot] = board;
+    return queue->queued[freeSlot];
 }
 
-int AssignNewTask(int priorityFlag,  Player * bot, int (*function)(void**), void** arguments, int argumentCount, void** flags, int flagCount){
+static int IsCellQueued(unsigned char * queued, int row, int col){
+
+    int index = row * GRIDSIZE + col;
+    return (queued[index >> 3] >> (index & 7)) & 1;
+}
 
-    BotTask * task = CreateTask(function, arguments, argumentCount, flags, flagCount);
+/**
+ * Sets or clears the queued bit of the task's cell on its board.
+ */
+static void SetTaskQueued(BotTaskQueue * queue, BotTask * task, int isQueued){
 
-    //printf("func ptr: %p\n", function);
+    unsigned char * queued = QueuedCellsOfBoard(queue, task->target, 0);
+    if (queued == NULL) return;
+
+    int index = task->row * GRIDSIZE + task->col;
+
+    if (isQueued) queued[index >> 3] |= (unsigned char)(1 << (index & 7));
+    else queued[index >> 3] &= (unsigned char)~(1 << (index & 7));
+}
+
+/**
+ * Returns the queued task with the same kind, cell and target, or NULL if there is none.
+ */
+static BotTask * FindQueuedTask(BotTaskQueue * queue, BotTaskKind kind, int row, int col, Player * target){
 
-    switch (priorityFlag)
+    for (int i = 0; i < queue->count; i++)
     {
-    case TASKFLAG_HIGHPRIORITY:
-        //We add the task at the top of the stack for high importance
-        addFirst(bot->stackMemory, (void*)task);
-        break;
+        BotTask * task = &queue->tasks[(queue->head + i) & (queue->capacity - 1)];
+        if (task->kind == kind && task->row == row && task->col == col && task->target == target) return task;
+    }
+
+    return NULL;
+}
+
+/**
+ * Doubles the buffer of a full queue, unwrapping its tasks to the start of the new buffer.
+ */
+static int GrowTaskQueue(BotTaskQueue * queue){
+
+    int capacity = queue->capacity == 0 ? 16 : queue->capacity * 2;
+
+    BotTask * tasks = (BotTask*)(alloc_Tracked(MEM_TASKS, sizeof(BotTask) * capacity));
+    if (tasks == NULL) return 0;
+
+    METRIC_COUNT(COUNTER_ALLOCATIONS);
 
-    case TASKFLAG_LOWPRIORITY:
+    for (int i = 0; i < queue->count; i++)
+    {
+        tasks[i] = queue->tasks[(queue->head + i) & (queue->capacity - 1)];
+    }
+
+    FreeTracked(queue->tasks);
+    queue->tasks = tasks;
+    queue->capacity = capacity;
+    queue->head = 0;
+
+    return 1;
+}
+
+/**
+ * Queues a task at the top (high priority) or at the bottom (low priority) of the bot's stack memory.
+ * 
+ * A cell is only queued once: queuing it again with a low priority keeps the queued task where it is, with a high priority it moves it to
+ * the top.
+ */
+int AssignNewTask(int priorityFlag, Player * bot, BotTaskKind kind, int row, int col, Player * target){
+
+    BotTaskQueue * queue = &bot->stackMemory;
+
+    if (priorityFlag != TASKFLAG_HIGHPRIORITY && priorityFlag != TASKFLAG_LOWPRIORITY) return 0;
+
+    unsigned char * queued = QueuedCellsOfBoard(queue, target, 1);
+
+    if (queued != NULL && IsCellQueued(queued, row, col)){
+
+        BotTask * queuedTask = FindQueuedTask(queue, kind, row, col, target);
+
+        if (queuedTask != NULL){
+            if (priorityFlag == TASKFLAG_LOWPRIORITY || queuedTask == PeekTask(queue)) return 1;
+            queuedTask->kind = TASK_DROPPED;
+        }
+    }
+
+    if (queue->count == queue->capacity && !GrowTaskQueue(queue)) return 0;
+
+    int mask = queue->capacity - 1;
+    int index;
+
+    if (priorityFlag == TASKFLAG_HIGHPRIORITY){
+        //We add the task at the top of the stack for high importance
+        queue->head = (queue->head - 1) & mask;
+        index = queue->head;
+    }
+    else {
         //We add the task at the bottom of the stack for low importance
-        addLast(bot->stackMemory, (void*)task);
-        break;
-    
-    default:
-        return 0;
+        index = (queue->head + queue->count) & mask;
     }
 
+    BotTask * task = &queue->tasks[index];
+    task->target = target;
+    task->row = row;
+    task->col = col;
+    task->kind = (unsigned char)kind;
+    task->priority = (unsigned char)priorityFlag;
+
+    queue->count++;
+    SetTaskQueued(queue, task, 1);
+    METRIC_COUNT(COUNTER_TASKS_QUEUED);
 
     return 1;
+}
+
+/**
+ * Frees the bot's stack memory along with every task still in it.
+ */
+void FreeBotStackMemory(Player * bot){
 
+    FreeTracked(bot->stackMemory.tasks);
 
+    for (int i = 0; i < TASKQUEUE_BOARDS; i++)
+    {
+        FreeTracked(bot->stackMemory.queued[i]);
+    }
+
+    InitializeTaskQueue(&bot->stackMemory, 0);
 }
 
+/**
+ * Pops the top task of the bot's stack memory into task, skipping dropped ones. Returns 0 if there is none.
+ */
+int GetNextTask(Player * bot, BotTask * task){
 
-BotTask * GetNextTask(Player * bot){
+    BotTaskQueue * queue = &bot->stackMemory;
 
-    if (is_empty(bot->stackMemory)) return NULL;
+    while (queue->count > 0)
+    {
+        *task = queue->tasks[queue->head];
+        queue->head = (queue->head + 1) & (queue->capacity - 1);
+        queue->count--;
 
-    return (BotTask*)removeFirst(bot->stackMemory);
+        if (task->kind != TASK_DROPPED){
+            SetTaskQueued(queue, task, 0);
+            return 1;
+        }
+    }
 
+    return 0;
 }
 
 /**
@@ -570,196 +831,239 @@ BotTask * GetNextTask(Player * bot){
  * 
  * Output:
  *      - The function returns 1 if task was successful
- *      - It returns 0 if task was not successful
+ *      - It returns 0 or less if task was not successful
  * 
  */
-int PerformTask(BotTask * task){
+int PerformTask(Player * bot, BotTask * task){
 
-    /**
-     * We must call the function specified in the task and pass it the arguments 
-     */
+    switch (task->kind)
+    {
+    case TASK_FIRE:
+        //Cells that can no longer hold a ship are dropped without wasting a shot:
+        if (!IsTargetCellPossible(task->target, task->row, task->col)) return 0;
+        return BotFireHelper(task->row, task->col, bot, task->target);
 
-    if (task->function == NULL) return 0;
+    default:
+        return 0;
+    }
+}
 
-    printf("func ptr in perfTask: %p\n", task->function);
-    return task->function(task->arguments);
+#pragma endregion
 
-}
+#pragma region [Target Mode]
 
-#pragma region [Bot Firing Systems]
 /**
- * Input:
- *      - int row: the row number of the targeted cell
- *      - int col: the column number of the targeted cell
- *      - Player * bot
- *      - Player * opponent
+ * Returns 1 if the cell is a hit on a ship that is still afloat.
  */
-int BotFire(void** args){
-    
-    printf("YOUY!\n");
-    if (args == NULL) return 0;
+static int IsOpenHit(Player * opponent, int row, int col){
 
-    int row = *(int*)args[0];
-    int col = *(int*)args[1];
+    if (!IndexWithinRange(row) || !IndexWithinRange(col) || opponent->grid[row][col] != HIT) return 0;
 
-    Player * bot = (Player*)args[2];
+    return checkIfSunk(opponent, opponent->shipIdGrid[row][col]) < 0;
+}
 
-    Player * opponent = (Player*)args[3];
+/**
+ * Returns 1 if a ship still afloat could cover the cell: it is within the grid, not a miss and not part of a sunk ship.
+ */
+static int IsOpenCell(Player * opponent, int row, int col){
 
-    BotFireHelper(row, col, bot, opponent);
+    if (!IndexWithinRange(row) || !IndexWithinRange(col) || opponent->grid[row][col] == MISS) return 0;
 
+    return opponent->grid[row][col] != HIT || IsOpenHit(opponent, row, col);
 }
 
-int BotFireHelper(int row, int col, Player * bot, Player * opponent){
+/**
+ * Number of consecutive cells passing test after (row, col) in the direction (rowStep, colStep).
+ */
+static int RunLength(Player * opponent, int row, int col, int rowStep, int colStep, int (*test)(Player*, int, int)){
 
-    char * coords = alloc_GetCoordsFromIndices(row, col, GRIDSIZE, startingCoordinate_1, startingCoordinate_2,
-     endingCoordinate_1, endingCoordinate_2, coord_1_shift, coord_2_shift);
+    int length = 0;
 
-    startfire:
+    while (test(opponent, row + (length + 1) * rowStep, col + (length + 1) * colStep)) length++;
 
-    //Make sure the bot doesn't shoot a previously shot cell
+    return length;
+}
 
-    printf("Fire Coords: %s\n", coords);
+/**
+ * Returns 1 if a ship still afloat, of length 2 or more, fits along the axis (rowStep, colStep) through both the cell and the hit next to it.
+ */
+static int CanExtendHit(Player * opponent, int row, int col, int rowStep, int colStep){
 
-    printf("8,8 is: %s\n", alloc_GetCoordsFromIndices(8, 8, GRIDSIZE, startingCoordinate_1, startingCoordinate_2,
-     endingCoordinate_1, endingCoordinate_2, coord_1_shift, coord_2_shift));
+    Fleet * fleet = &opponent->fleet;
 
-    char * error = NULL;
-    int fireRes = Fire(coords, opponent->grid, DifficultyValue, &error);
+    int span = 1 + RunLength(opponent, row, col, rowStep, colStep, IsOpenCell) + RunLength(opponent, row, col, -rowStep, -colStep, IsOpenCell);
 
+    for (int length = 2; length <= MIN(span, fleet->maxLength); length++)
+    {
+        if (fleet->afloatByLength[length] > 0) return 1;
+    }
 
-    if (fireRes < 0){
-        if (error != NULL) free(error);
+    return 0;
+}
 
-        goto startfire;
+/**
+ * Returns 1 if the cell is still worth a target mode shot: it was not shot, and a ship still afloat could cover it along with a hit next to
+ * it. A cell next to hits of sunk ships only, or squeezed between misses, returns 0.
+ */
+int IsTargetCellPossible(Player * opponent, int row, int col){
+
+    if (!IndexWithinRange(row) || !IndexWithinRange(col)) return 0;
+    if (opponent->grid[row][col] == HIT || opponent->grid[row][col] == MISS) return 0;
+
+    const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (IsOpenHit(opponent, row + steps[i][0], col + steps[i][1]) && CanExtendHit(opponent, row, col, steps[i][0], steps[i][1])) return 1;
     }
 
+    return 0;
+}
 
-    int target[2] = {row,col};
+/**
+ * Drops the queued tasks that became pointless (target out of the game, cell no longer possible), keeping the others in order.
+ */
+static void PruneTasks(Player * bot){
 
+    BotTaskQueue * queue = &bot->stackMemory;
+    int mask = queue->capacity - 1;
+    int kept = 0;
 
-    //Updating the probability distribution:
-    UpdateSurroundingProbabilities(opponent, target);
+    for (int i = 0; i < queue->count; i++)
+    {
+        BotTask * task = &queue->tasks[(queue->head + i) & mask];
 
+        if (task->kind == TASK_DROPPED) continue;
 
-    printf("BEF UPDHEAPWITHINBND\n");
-    
-    DisplayIntGrid(opponent->probabilityGrid, GRIDSIZE);
+        if (!IsPlayerAlive(task->target) || !IsTargetCellPossible(task->target, task->row, task->col)){
+            SetTaskQueued(queue, task, 0);
+            continue;
+        }
 
-    //Update the probability heaps for all the probability regions that surround the target.
-    UpdateHeapsWithinBounds(opponent, MAX(0, row - LONGEST_SHIPLENGTH), MIN(GRIDSIZE, row + LONGEST_SHIPLENGTH),
-     MAX(0, col - LONGEST_SHIPLENGTH), MIN(GRIDSIZE, col + LONGEST_SHIPLENGTH));
+        queue->tasks[(queue->head + kept) & mask] = *task;
+        kept++;
+    }
 
-    
-    DisplayIntGrid(opponent->probabilityGrid, GRIDSIZE);
+    queue->count = kept;
+}
+
+/**
+ * Queues the cells to shoot after a hit that did not sink its ship.
+ * 
+ * When the hit lines up with other open hits, and a ship still afloat is longer than that line, the ship most likely lies along it: the two
+ * cells past the ends of the line go on top of the stack, and the cells across the line at the bottom, in case the hits belong to ships
+ * lying side by side. Otherwise the 4 neighbours go on top, as for a first hit. Cells that can't hold a ship through the hit are not queued.
+ */
+static void QueueTargetCells(Player * bot, Player * opponent, int row, int col){
 
-    //Need to check if the target was a HIT or a MISS. If it's a HIT then we assign 4 new tasks to target the surrounding cells:
-    if(opponent->grid[row][col] == HIT){
-        if (IndexWithinRange(row + 1)){
-            if (opponent->grid[row+1][col] != HIT && opponent->grid[row+1][col] != MISS){
+    const int axes[2][2] = {{1, 0}, {0, 1}};
 
-                int argCount = 4;
-                void ** args = (void**)(malloc(sizeof(void*) * argCount));
+    int lineAxis = -1;
+    int lineLength = 1;
 
-                for (int i = 0; i < argCount; i++)
-                {
-                    args[i] = (void*)(malloc(sizeof(void*)));
-                }
-                
-                int* rowPtr = (int*)(malloc(sizeof(int)));
-                *rowPtr = row + 1;
-                int* colPtr = (int*)(malloc(sizeof(int)));
-                *colPtr = col;
-
-                //Setting the arguments:
-                args[0] = rowPtr;
-                args[1] = colPtr;
-                args[2] = bot;
-                args[3] = opponent;
-                
-
-                AssignNewTask(TASKFLAG_HIGHPRIORITY, bot, BotFire, args, argCount, NULL, 0);
-            }
-        }
+    for (int a = 0; a < 2; a++)
+    {
+        int length = 1 + RunLength(opponent, row, col, axes[a][0], axes[a][1], IsOpenHit) + RunLength(opponent, row, col, -axes[a][0], -axes[a][1], IsOpenHit);
 
-        if (IndexWithinRange(row - 1)){
-            if (opponent->grid[row-1][col] != HIT && opponent->grid[row-1][col] != MISS){
-                int argCount = 4;
-                void ** args = (void**)(malloc(sizeof(void*) * argCount));
+        if (length > lineLength){
+            lineAxis = a;
+            lineLength = length;
+        }
+        else if (length == lineLength && length > 1) lineAxis = -1; //Hits both ways, no axis stands out.
+    }
 
-                for (int i = 0; i < argCount; i++)
-                {
-                    args[i] = (void*)(malloc(sizeof(void*)));
-                }
-                
-                int* rowPtr = (int*)(malloc(sizeof(int)));
-                *rowPtr = row - 1;
-                int* colPtr = (int*)(malloc(sizeof(int)));
-                *colPtr = col;
-
-                //Setting the arguments:
-                args[0] = rowPtr;
-                args[1] = colPtr;
-                args[2] = bot;
-                args[3] = opponent;
-                
-
-                AssignNewTask(TASKFLAG_HIGHPRIORITY, bot, BotFire, args, argCount, NULL, 0);
-            }
+    if (lineAxis >= 0){
+        int longest = 0;
+        for (int length = opponent->fleet.maxLength; length > 0 && longest == 0; length--)
+        {
+            if (opponent->fleet.afloatByLength[length] > 0) longest = length;
         }
 
-        if (IndexWithinRange(col + 1)){
-            if (opponent->grid[row][col+1] != HIT && opponent->grid[row][col+1] != MISS){
-                int argCount = 4;
-                void ** args = (void**)(malloc(sizeof(void*) * argCount));
+        if (longest <= lineLength) lineAxis = -1;
+    }
 
-                for (int i = 0; i < argCount; i++)
-                {
-                    args[i] = (void*)(malloc(sizeof(void*)));
-                }
-                
-                int* rowPtr = (int*)(malloc(sizeof(int)));
-                *rowPtr = row;
-                int* colPtr = (int*)(malloc(sizeof(int)));
-                *colPtr = col + 1;
-
-                //Setting the arguments:
-                args[0] = rowPtr;
-                args[1] = colPtr;
-                args[2] = bot;
-                args[3] = opponent;
-                
-
-                AssignNewTask(TASKFLAG_HIGHPRIORITY, bot, BotFire, args, argCount, NULL, 0);
+    //Same order as always: the last task queued is the first performed.
+    for (int a = 0; a < 2; a++)
+    {
+        if (a == lineAxis) continue;
+
+        for (int side = 1; side >= -1; side -= 2)
+        {
+            int r = row + side * axes[a][0];
+            int c = col + side * axes[a][1];
+
+            if (IsTargetCellPossible(opponent, r, c)){
+                AssignNewTask(lineAxis < 0 ? TASKFLAG_HIGHPRIORITY : TASKFLAG_LOWPRIORITY, bot, TASK_FIRE, r, c, opponent);
             }
         }
+    }
 
-        if (IndexWithinRange(col - 1)){
-            if (opponent->grid[row][col-1] != HIT && opponent->grid[row][col-1] != MISS){
-                int argCount = 4;
-                void ** args = (void**)(malloc(sizeof(void*) * argCount));
+    if (lineAxis < 0) return;
 
-                for (int i = 0; i < argCount; i++)
-                {
-                    args[i] = (void*)(malloc(sizeof(void*)));
-                }
-                
-                int* rowPtr = (int*)(malloc(sizeof(int)));
-                *rowPtr = row;
-                int* colPtr = (int*)(malloc(sizeof(int)));
-                *colPtr = col - 1;
-
-                //Setting the arguments:
-                args[0] = rowPtr;
-                args[1] = colPtr;
-                args[2] = bot;
-                args[3] = opponent;
-                
-
-                AssignNewTask(TASKFLAG_HIGHPRIORITY, bot, BotFire, args, argCount, NULL, 0);
-            }
+    for (int side = 1; side >= -1; side -= 2)
+    {
+        int rowStep = side * axes[lineAxis][0];
+        int colStep = side * axes[lineAxis][1];
+        int reach = 1 + RunLength(opponent, row, col, rowStep, colStep, IsOpenHit);
+
+        int r = row + reach * rowStep;
+        int c = col + reach * colStep;
+
+        if (IsTargetCellPossible(opponent, r, c)){
+            AssignNewTask(TASKFLAG_HIGHPRIORITY, bot, TASK_FIRE, r, c, opponent);
         }
     }
+}
+
+#pragma endregion
+
+#pragma region [Bot Firing Systems]
+/**
+ * Input:
+ *      - int row: the row number of the targeted cell
+ *      - int col: the column number of the targeted cell
+ *      - Player * bot
+ *      - Player * opponent
+ */
+int BotFireHelper(int row, int col, Player * bot, Player * opponent){
+
+    TRACE_SCOPE("BotFireHelper");
+
+    AcquireProbabilityState(opponent);
+
+    char * coords = alloc_GetCoordsFromIndices(row, col, GRIDSIZE, startingCoordinate_1, startingCoordinate_2,
+     endingCoordinate_1, endingCoordinate_2, coord_1_shift, coord_2_shift);
+
+    //Make sure the bot doesn't shoot a previously shot cell
+
+    printf("Fire Coords: %s\n", coords);
+
+    char * error = NULL;
+
+    //The probabilities and heaps are updated by the shot itself (see UpdateShotProbabilities()):
+    int fireRes = Fire(coords, bot, opponent, DifficultyValue, &error);
+
+
+    //The cell was hit since the task was queued (possibly by another player), the task is dropped:
+    if (fireRes < 0){
+        if (error != NULL) FreeTracked(error);
+        FreeTracked(coords);
+
+        return fireRes;
+    }
+
+
+    int shipID = opponent->shipIdGrid[row][col];
+
+    //Need to check if the target was a HIT or a MISS. If it's a HIT then we queue the cells around it (see QueueTargetCells()). If it sunk
+    //the ship, the cells queued for it that no other hit explains are dropped:
+    if (opponent->grid[row][col] == HIT){
+        if (checkIfSunk(opponent, shipID) > 0) PruneTasks(bot);
+        else QueueTargetCells(bot, opponent, row, col);
+    }
+
+    if (error != NULL) FreeTracked(error);
+    FreeTracked(coords);
 
     return fireRes;
 
@@ -775,103 +1079,145 @@ int BotFireHelper(int row, int col, Player * bot, Player * opponent){
 //and tries to place ships in accordingly.
 #pragma region [BOT PLACEMENT]
 
-int BotPickRandomIndicesWithinBounds(int * outRow, int * outCol, char** grid, int shipSize[2], char* orientation, int startRow, int endRow, int startCol, int endCol){
-    
+/**
+ * Seeds the placement generators. rand() is not used because it is reseeded with time(0) all over the code.
+ */
+static unsigned long long BotPlacementSeed(Player * bot){
 
-    start:
-    int rowMax = endRow, colMax = endCol;
+    unsigned long long seed = ((unsigned long long)time(0) << 20) ^ (unsigned long long)clock() ^ (unsigned long long)(size_t)bot;
 
-    
+    return (seed != 0) ? seed : 1;
+}
 
-    if (strcmpi(orientation, "h") == 0){
-        colMax -= shipSize[0];
-    }
-    else {
-        rowMax -= shipSize[0];
+/**
+ * Allocates an occupancy board holding the ships that might already be on the bot's grid, so the generators avoid them.
+ */
+static OccupancyBoard * alloc_BotOccupancyBoard(Player * bot){
+
+    OccupancyBoard * board = (OccupancyBoard*)(alloc_Tracked(MEM_GRIDS, sizeof(OccupancyBoard)));
+    InitializeOccupancyBoard(board);
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            if (IsShip(bot->grid[i][j])){
+                int cell[4] = {i, i, j, j};
+                MarkOccupied(board, cell);
+            }
+        }
     }
 
-    printf("startRow = %d, rowMax = %d\n", startRow, rowMax);
+    return board;
+}
+
+/**
+ * Places the bot's fleet uniformly at random. The positions are drawn by the rejection-free generator in ShipPlacement.c from the
+ * bot's occupancy bitmask and placed directly in array coordinates, so there is no retrying and no string conversions.
+ */
+void PlaceBotShipsRandomly(Player *bot) {
 
-    int row = startRow + (rand() % rowMax);
-    int col = startCol + (rand() % colMax);
+    Fleet * fleet = &bot->fleet;
 
-    printf("%d,%d\n", row, col);
+    unsigned long long rngState = BotPlacementSeed(bot);
 
-    char * coords = alloc_GetCoordsFromIndices(row, col, GRIDSIZE, startingCoordinate_1, startingCoordinate_2, endingCoordinate_1, endingCoordinate_2, coord_1_shift, coord_2_shift);
+    OccupancyBoard * board = alloc_BotOccupancyBoard(bot);
 
-    printf("%s\n",coords);
-    printf("%s\n",orientation);
-    
-    char * error = NULL;
+    for (int shipID = 1; shipID <= fleet->shipCount; shipID++) {
 
-    int * shipBounds = alloc_GridAreaFromInput(coords, orientation, shipSize[0] - 1, shipSize[1], &error);
+        int bounds[4];
 
-    if (error != NULL) printf("%s\n", error);
-    
-    printf("huhh\n");
-    printf("%d, %d,%d,%d\n", shipBounds[0], shipBounds[1], shipBounds[2], shipBounds[3]);
+        if (!PickRandomShipPlacement(board, fleet->length[shipID], &rngState, bounds)){
+            printf("Could not find room for the bot's %s!\n", ShipTypeName(fleet->length[shipID]));
+            continue;
+        }
 
-    if (CheckForOverlap(grid, shipBounds)){
-        printf("there was an overlap\n");
-        free(coords);
-        free(shipBounds);
-        if (error != NULL) free(error);
-        goto start;
+        PlaceShipAtBounds(bot, shipID, bot->grid, bounds, NULL);
     }
 
-    *outRow = row;
-    *outCol = col;
+    FreeTracked(board);
+}
 
-    free(coords);
-    free(shipBounds);
-    if (error != NULL) free(error);
+/**
+ * Places the bot's fleet where an opponent is least likely to look. density is a GRIDSIZE x GRIDSIZE grid of how likely each cell is to be
+ * targeted: the probability model of CalcProbs.c (which is how our own bot hunts) or a heatmap of an opponent's past shots.
+ * LOWDENSITY_CANDIDATES random fleets are scored against it and the lowest one is placed. Since every candidate is still drawn at random,
+ * two games against the same density don't end up with the same fleet.
+ * 
+ * Falls back to random placement if no candidate fits.
+ */
+void PlaceBotShipsAgainstDensity(Player *bot, int ** density) {
 
-    return 1;
-}
+    Fleet * fleet = &bot->fleet;
+    int (*bounds)[4] = (int (*)[4])(alloc_Tracked(MEM_GRIDS, sizeof(int[4]) * fleet->shipCount));
 
+    OccupancyBoard * board = alloc_BotOccupancyBoard(bot);
+    int ** densityTable = alloc_DensityAreaTable(density);
 
+    //The lengths of ship IDs 1 to shipCount are stored from index 1:
+    long long score = PickLowDensityFleet(board, densityTable, &fleet->length[1], fleet->shipCount, LOWDENSITY_CANDIDATES, BotPlacementSeed(bot), bounds);
 
-void PlaceBotShips(Player *bot) {
+    FreeDensityAreaTable(densityTable);
+    FreeTracked(board);
 
-    srand(time(0));
+    if (score < 0){
+        FreeTracked(bounds);
+        PlaceBotShipsRandomly(bot);
+        return;
+    }
 
-    char shipTypes[] = {SUBMARINE_C, DESTROYER_C, BATTLESHIP_C, CARRIER_C};
-    int ShipSizes[SHIPCOUNT][2] = {{2,0}, {3,0}, {4,0}, {5,0}};
+    for (int i = 0; i < fleet->shipCount; i++)
+    {
+        PlaceShipAtBounds(bot, i + 1, bot->grid, bounds[i], NULL);
+    }
 
-    for (int i = 0; i < SHIPCOUNT; i++) {
-        char orientation[2];
-        int horizontal = rand() % 2;
+    FreeTracked(bounds);
+}
 
-        // Set orientation to 'H' for horizontal or 'V' for vertical
-        orientation[0] = horizontal ? 'h' : 'v';
-        orientation[1] = '\0';
+/**
+ * Smart bots hide their fleet from the probability model they use themselves and from the cells their known opponents usually fire at in
+ * their first shots (see Profiles.h). The others place it uniformly at random. opponents may contain bots and players without history,
+ * they are skipped.
+ */
+void PlaceBotShips(Player *bot, Player ** opponents, int opponentCount) {
 
-        int row;
-        int col;
+    //Only the starting grid is read, so a shared one is enough:
+    if (bot->botIQ == SMART) PrepareProbabilityGrid(bot);
 
-        BotPickRandomIndicesWithinBounds(&row, &col, bot->grid, ShipSizes[i], orientation, 0, GRIDSIZE - 1, 0, GRIDSIZE - 1);
+    if (bot->botIQ != SMART || bot->probabilityGrid == NULL){
+        PlaceBotShipsRandomly(bot);
+        return;
+    }
 
-        printf("%d,%d\n", row, col);
-        // Convert to user coordinates
-        char * coords = alloc_GetCoordsFromIndices(row, col, GRIDSIZE, startingCoordinate_1, startingCoordinate_2, endingCoordinate_1, endingCoordinate_2, coord_1_shift, coord_2_shift);
-        
-        //printf("%d, %d\n", ShipSizes[i][0], ShipSizes[i][1]);
-        //printf("%s\n", coords);
-        // Try to place the ship
-        char * error = NULL;
-        PlaceShipOnGridHelper(bot, shipTypes[i], bot->grid, coords, orientation, ShipSizes[i], &error);
+    //The whole grid is read:
+    RefineProbabilities(bot);
 
-        printf("%s\n", error);
+    int highest = 1;
+    int ** density = (int**)(alloc_Tracked(MEM_GRIDS, sizeof(int*) * GRIDSIZE));
 
-        printf("%c\n", coords[0]);
-        
-        free (coords);
-        if(error != NULL) free(error);
-        
-        //char c;
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        density[i] = (int*)(alloc_Tracked(MEM_GRIDS, sizeof(int) * GRIDSIZE));
+
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            density[i][j] = bot->probabilityGrid[i][j];
+            highest = MAX(highest, density[i][j]);
+        }
+    }
 
-        //scanf("%c", &c);
+    for (int p = 0; p < opponentCount; p++)
+    {
+        if (opponents[p] != bot) AddEarlyCoverage(opponents[p], density, highest * PROFILE_COVERAGE_WEIGHT);
+    }
+
+    PlaceBotShipsAgainstDensity(bot, density);
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        FreeTracked(density[i]);
     }
+    FreeTracked(density);
 }
 
 #pragma endregion
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "../include/defs.h"
 #include "../include/Player.h"
 #include "../include/CalcProbs.h"
+#include "../include/Metrics.h"
+#include "../include/Trace.h"
 
 
 int CheckHitOrMiss(char** grid, int target[2]) // checks if the cell is a hit or a miss
@@ -14,96 +16,67 @@ int CheckHitOrMiss(char** grid, int target[2]) // checks if the cell is a hit or
 }
 
 
-int CalcCutoffProb(Player *player, int target[2]) // player here is the opponent
+/**
+ * Number of placements of the ships still afloat that cover the cell, only accounting for the grid edges. The fleet keeps how many ships
+ * of each length are afloat, so this loops over lengths rather than over ships, and sunk ships are already excluded.
+ * 
+ * If the player was seen in past games, the prior of their usual placements is added (see Profiles.h).
+ */
+static int CutoffPlacements(Player *player, int rowc, int colc)
 {
-    int rowc = target[0];
-    int colc = target[1];
+    Fleet *fleet = &player->fleet;
 
-    //printf("%d\n", rowc);
-
-    if (rowc < 0 || rowc >= GRIDSIZE || colc < 0 || colc >= GRIDSIZE)
-    {
-        printf("Invalid target coordinates.\n");
-        return 0;
-    }
+    int Horimax = (colc + 1 < GRIDSIZE - colc) ? colc + 1 : GRIDSIZE - colc;
+    int Vertimax = (rowc + 1 < GRIDSIZE - rowc) ? rowc + 1 : GRIDSIZE - rowc;
 
-    player->probabilityGrid[rowc][colc] = 0; // initializing the certain cell to zero
+    int placements = 0;
 
-    ShipBounds ships[] = {
-        player->carrierBounds,
-        player->battleshipBounds,
-        player->destroyerBounds,
-        player->submarineBounds}; // add ships to an array to use their size and to know if one of them is sunked
-
-    for (int s = 0; s < SHIPCOUNT; s++)
+    for (int shipLength = 1; shipLength <= fleet->maxLength; shipLength++)
     {
-        if (ships[s].IsSunk)
-            continue; // skipping the ship if its sunk
-
-        int shipLength = ships[s].endRow - ships[s].startRow + 1; // Use ship bounds to determine length
-        if (shipLength == 1)
-            shipLength = ships[s].endCol - ships[s].startCol + 1;
+        if (fleet->afloatByLength[shipLength] == 0)
+            continue;
 
-        int Horiprob = (colc + 1 < GRIDSIZE - colc) ? colc + 1 : GRIDSIZE - colc;
-        if (Horiprob > shipLength)
-            Horiprob = shipLength;
+        int Horiprob = (Horimax > shipLength) ? shipLength : Horimax;
         /*the formula is the probability of the ship to pass here horizontally is
         the minimum between nb of cells left to the cell, right to the cell and the shiplength
         */
 
-        int Vertiprob = (rowc + 1 < GRIDSIZE - rowc) ? rowc + 1 : GRIDSIZE - rowc;
-        if (Vertiprob > shipLength)
-            Vertiprob = shipLength;
+        int Vertiprob = (Vertimax > shipLength) ? shipLength : Vertimax;
         // same formula but vertical
 
-        player->probabilityGrid[rowc][colc] += Horiprob + Vertiprob; // adding both probabilities to the cell in the probgrid
-
-        //printf("%d\n", Horiprob);
+        placements += fleet->afloatByLength[shipLength] * (Horiprob + Vertiprob);
     }
-    return 1;
+
+    if (player->placementPrior != NULL)
+        placements += PlacementPriorBonus(player->placementPrior, fleet->afloatByLength, rowc, colc);
+
+    return placements;
 }
 
-int InitalizeCutOffProb(Player *player, int target[2]) // player here is the opponent
+int CalcCutoffProb(Player *player, int target[2]) // player here is the opponent
 {
     int rowc = target[0];
     int colc = target[1];
 
-    //printf("%d\n", rowc);
-
     if (rowc < 0 || rowc >= GRIDSIZE || colc < 0 || colc >= GRIDSIZE)
     {
         printf("Invalid target coordinates.\n");
         return 0;
     }
 
-    player->probabilityGrid[rowc][colc] = 0; // initializing the certain cell to zero
-
-    int ShipSizes[] = SHIPSIZES;
-
-    for (int s = 0; s < SHIPCOUNT; s++)
-    {
-
-        int shipLength = ShipSizes[s];
-
-        int Horiprob = (colc + 1 < GRIDSIZE - colc) ? colc + 1 : GRIDSIZE - colc;
-        if (Horiprob > shipLength)
-            Horiprob = shipLength;
-        /*the formula is the probability of the ship to pass here horizontally is
-        the minimum between nb of cells left to the cell, right to the cell and the shiplength
-        */
+    player->probabilityGrid[rowc][colc] = ToProbabilityValue(CutoffPlacements(player, rowc, colc)); // adding both probabilities of every ship to the cell in the probgrid
 
-        int Vertiprob = (rowc + 1 < GRIDSIZE - rowc) ? rowc + 1 : GRIDSIZE - rowc;
-        if (Vertiprob > shipLength)
-            Vertiprob = shipLength;
-        // same formula but vertical
-
-        player->probabilityGrid[rowc][colc] += Horiprob + Vertiprob; // adding both probabilities to the cell in the probgrid
-
-        //printf("%d\n", Horiprob);
-    }
     return 1;
 }
 
+/**
+ * Same as CalcCutoffProb(). It is used before any shot, when the whole fleet is still afloat.
+ */
+int InitalizeCutOffProb(Player *player, int target[2]) // player here is the opponent
+{
+    return CalcCutoffProb(player, target);
+}
+
 int CalcOverlapProb(Player *player, int target[2])
 {
     int rowc = target[0];
@@ -115,56 +88,60 @@ int CalcOverlapProb(Player *player, int target[2])
         return 0;
     }
 
-    int adjustment = 0;
+    Fleet *fleet = &player->fleet;
 
-    ShipBounds ships[] = {
-        player->carrierBounds,
-        player->battleshipBounds,
-        player->destroyerBounds,
-        player->submarineBounds};
+    int adjustment = 0;
+    int reach = 0; // the adjustment of the cells within distance i, which is what a ship of length i + 1 sees
 
-    for (int s = 0; s < SHIPCOUNT; s++)
+    for (int i = 0; i < fleet->maxLength; i++)
     {
-        if (ships[s].IsSunk)
-            continue; // skip the ship if its sunk
+        if (rowc - i >= 0 && player->grid[rowc - i][colc] == HIT)
+            reach++;
+        else if (rowc - i >= 0 && player->grid[rowc - i][colc] == MISS)
+            reach--;
+
+        if (colc - i >= 0 && player->grid[rowc][colc - i] == HIT)
+            reach++;
+        else if (colc - i >= 0 && player->grid[rowc][colc - i] == MISS)
+            reach--;
+
+        if (colc + i < GRIDSIZE && player->grid[rowc][colc + i] == HIT)
+            reach++;
+        else if (colc + i < GRIDSIZE && player->grid[rowc][colc + i] == MISS)
+            reach--;
+
+        if (rowc + i < GRIDSIZE && player->grid[rowc + i][colc] == HIT)
+            reach++;
+        else if (rowc + i < GRIDSIZE && player->grid[rowc + i][colc] == MISS)
+            reach--;
+        // for all above, below, left or right cells to a certain cell by the size of the ship, we check
+        // if these are hits misses or none and update the variable adjustments based on that
+
+        adjustment += fleet->afloatByLength[i + 1] * reach; // every afloat ship of length i + 1 adds what it can reach
+    }
 
-        int shipLength = ships[s].endRow - ships[s].startRow + 1;
-        if (shipLength == 1)
-            shipLength = ships[s].endCol - ships[s].startCol + 1;
+    player->probabilityGrid[rowc][colc] = ToProbabilityValue(player->probabilityGrid[rowc][colc] + adjustment);// adding adjustment to the original probability
+    return 1;
+}
 
-        for (int i = 0; i < shipLength; i++)
-        {
-            if (rowc - i >= 0 && player->grid[rowc - i][colc] == HIT)
-                adjustment++;
-            else if (rowc - i >= 0 && player->grid[rowc - i][colc] == MISS)
-                adjustment--;
-
-            if (colc - i >= 0 && player->grid[rowc][colc - i] == HIT)
-                adjustment++;
-            else if (colc - i >= 0 && player->grid[rowc][colc - i] == MISS)
-                adjustment--;
-
-            if (colc + i < GRIDSIZE && player->grid[rowc][colc + i] == HIT)
-                adjustment++;
-            else if (colc + i < GRIDSIZE && player->grid[rowc][colc + i] == MISS)
-                adjustment--;
-
-            if (rowc + i < GRIDSIZE && player->grid[rowc + i][colc] == HIT)
-                adjustment++;
-            else if (rowc + i < GRIDSIZE && player->grid[rowc + i][colc] == MISS)
-                adjustment--;
-            // for all above, below, left or right cells to a certain cell by the size of the ship, we check
-            // if these are hits misses or none and update the variable adjustments based on that
-        }
+/**
+ * Returns the length of the longest ship still afloat, which is how far a shot can affect probabilities.
+ */
+static int LongestAfloatLength(Fleet *fleet)
+{
+    for (int shipLength = fleet->maxLength; shipLength > 0; shipLength--)
+    {
+        if (fleet->afloatByLength[shipLength] > 0)
+            return shipLength;
     }
 
-    player->probabilityGrid[rowc][colc] += adjustment;// adding adjustment to the original probability
-    //printf("adjustment = %d\n", adjustment);
-    return 1;
+    return 0;
 }
 
 int UpdateSurroundingProbabilities(Player *player, int target[2])
 {
+    TRACE_SCOPE("UpdateSurroundingProbabilities");
+
     int rowc = target[0];
     int colc = target[1];
 
@@ -174,24 +151,14 @@ int UpdateSurroundingProbabilities(Player *player, int target[2])
         return 0;
     }
 
-    ShipBounds ships[] = {
-        player->carrierBounds,
-        player->battleshipBounds,
-        player->destroyerBounds,
-        player->submarineBounds};
+    int maxSize = LongestAfloatLength(&player->fleet); // the max size of ships that are not sunk tells us where to update the probabilities
 
-    int maxSize = 0;
-    for (int s = 0; s < SHIPCOUNT; s++)
+    // lazy boards only mark the cross as stale, its cells are computed when a query needs them
+    if (player->staleRegions != NULL)
     {
-        if (!ships[s].IsSunk)
-        {
-            int size = ships[s].endRow - ships[s].startRow + 1;
-            if (size == 1)
-                size = ships[s].endCol - ships[s].startCol + 1;
-            if (size > maxSize)
-                maxSize = size;
-            // calculating the max size of ships that are not sunk to know where to update the probabilities
-        }
+        MarkRegionsStale(player, rowc - maxSize, rowc + maxSize, colc, colc);
+        MarkRegionsStale(player, rowc, rowc, colc - maxSize, colc + maxSize);
+        return 1;
     }
 
     for (int i = rowc - maxSize; i <= rowc + maxSize; i++)
@@ -199,6 +166,7 @@ int UpdateSurroundingProbabilities(Player *player, int target[2])
         int VertiSurs[2] = {i, colc};
         if (i >= 0 && i < GRIDSIZE && !CheckHitOrMiss(player->grid, VertiSurs))
         {
+            METRIC_COUNT(COUNTER_CELLS_RECOMPUTED);
             CalcCutoffProb(player, VertiSurs);
             CalcOverlapProb(player, VertiSurs);
         }
@@ -210,6 +178,7 @@ int UpdateSurroundingProbabilities(Player *player, int target[2])
         int HortiSurs[2] = {rowc, i};
         if (i >= 0 && i < GRIDSIZE && !CheckHitOrMiss(player->grid, HortiSurs))
         {
+            METRIC_COUNT(COUNTER_CELLS_RECOMPUTED);
             CalcCutoffProb(player, HortiSurs);
             CalcOverlapProb(player, HortiSurs);
         }
@@ -219,8 +188,18 @@ int UpdateSurroundingProbabilities(Player *player, int target[2])
     return 1;
 }
 
+/**
+ * Returns 1 if the cell belonged to a ship that has already been sunk, 0 otherwise. This is an O(1) lookup in the shipIdGrid.
+ */
+static int IsSunkShipCell(Player *player, int row, int col)
+{
+    return checkIfSunk(player, player->shipIdGrid[row][col]) > 0;
+}
+
 int UpdateRegionProbabilities(Player *player, int target[4])
 {
+    TRACE_SCOPE("UpdateRegionProbabilities");
+
     int Hstart = target[0], Hend = target[1], Vstart = target[2], Vend = target[3];
 
     if (Hstart < 0 || Hend < 0 || Vstart < 0 || Vend < 0 ||
@@ -230,41 +209,63 @@ int UpdateRegionProbabilities(Player *player, int target[4])
         return 0;
     }
 
-    ShipBounds ships[] = {
-        player->carrierBounds,
-        player->battleshipBounds,
-        player->destroyerBounds,
-        player->submarineBounds};
+    if (MarkRegionsStale(player, Hstart, Hend, Vstart, Vend))
+        return 1;
+
+    long long recomputed = 0;
 
+    // every cell only writes itself, so row bands can be computed by different threads in any order
+    #pragma omp parallel for schedule(static) reduction(+:recomputed) if ((long long)(Hend - Hstart + 1) * (Vend - Vstart + 1) >= PROB_PARALLEL_MINCELLS)
     for (int i = Hstart; i <= Hend; i++)
     {
         for (int j = Vstart; j <= Vend; j++)
         {
             int cell[2] = {i, j};
-            bool skipCell = false;
 
             // Check if the cell is part of a sunk ship or is a hit or a miss
-            for (int s = 0; s < SHIPCOUNT; s++)
-            {
-                if (ships[s].IsSunk &&
-                        i >= ships[s].startRow && i <= ships[s].endRow &&
-                        j >= ships[s].startCol && j <= ships[s].endCol ||
-                    CheckHitOrMiss(player->grid, cell))
-                {
-                    skipCell = true;
-                    break;
-                }
-            }
+            bool skipCell = IsSunkShipCell(player, i, j) || CheckHitOrMiss(player->grid, cell);
 
             if (!skipCell)
             {
+                recomputed++;
                 CalcCutoffProb(player, cell);
                 CalcOverlapProb(player, cell);
             }
         }
     }
 
+    METRIC_ADD(COUNTER_CELLS_RECOMPUTED, recomputed);
+
     return 1;
 }
 
+/**
+ * Called the moment a ship sinks. Since the shipIdGrid tells us exactly which ship it was, we know which length no longer fits anywhere and
+ * recompute every cell that a ship crossing the sunk one could have reached. CalcCutoffProb() and CalcOverlapProb() skip sunk ships,
+ * so the recomputed cells stop counting the retired length. Against a player with a placement prior, the last ship of a length sinking
+ * also drops its heatmap from every cell, so the whole grid is recomputed.
+ */
+int RetireSunkShip(Player *player, int shipID)
+{
+    TRACE_SCOPE("RetireSunkShip");
+
+    if (checkIfSunk(player, shipID) < 0)
+        return 0;
+
+    Fleet *fleet = &player->fleet;
+
+    int region[4] = {
+        MAX(0, fleet->startRow[shipID] - fleet->maxLength), MIN(GRIDSIZE - 1, fleet->endRow[shipID] + fleet->maxLength),
+        MAX(0, fleet->startCol[shipID] - fleet->maxLength), MIN(GRIDSIZE - 1, fleet->endCol[shipID] + fleet->maxLength)};
 
+    // The heatmap of a retired length counted everywhere the player used to place it, not only around the ship
+    if (player->placementPrior != NULL && fleet->afloatByLength[fleet->length[shipID]] == 0)
+    {
+        region[0] = 0;
+        region[1] = GRIDSIZE - 1;
+        region[2] = 0;
+        region[3] = GRIDSIZE - 1;
+    }
+
+    return UpdateRegionProbabilities(player, region);
+}
@@ -0,0 +1,247 @@
+#include "../include/Consistency.h"
+
+#ifdef ENABLE_CONSISTENCY_CHECK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/Player.h"
+#include "../include/CalcProbs.h"
+
+/**
+ * Divergence found by one check. Resolved cells (hits and misses) are left out of the grid comparison since the engine stops updating
+ * them once they are shot, and the heaps drop them. So are the stale regions of lazy boards, which only need to sit in one category.
+ */
+typedef struct ConsistencyReport{
+    int checkedCells;
+    int staleCells;
+    int maxDifference;
+    long long totalDifference;
+
+    int staleKeys;          //Heap elements whose probability is not the one in the probabilityGrid.
+    int resolvedElements;   //Heap elements left on cells that were already shot.
+    int missingCells;       //Unresolved lattice cells with a non zero probability (full recompute) that are in no heap.
+    int misplacedRegions;   //Regions in the wrong category list, in several, missing from all of them, or not in the one they record.
+    int staleRegions;       //Regions of a lazy board waiting for a query.
+} ConsistencyReport;
+
+static ProbabilityValue ** ReferenceGrid = NULL;
+static char ** SeenGrid = NULL;
+
+static FILE * ConsistencyOutput = NULL;
+
+static int MovesChecked = 0;
+static int MovesDiverged = 0;
+static int WorstDifference = 0;
+static long long TotalStaleCells = 0;
+
+#pragma region [REFERENCE]
+
+/**
+ * The checker's grids are not part of the game, so they are taken from malloc() directly and never show up in the memory accounting.
+ */
+static void InitializeConsistencyGrids(){
+
+    ReferenceGrid = (ProbabilityValue**)(malloc(sizeof(ProbabilityValue*) * GRIDSIZE));
+    SeenGrid = (char**)(malloc(sizeof(char*) * GRIDSIZE));
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        ReferenceGrid[i] = (ProbabilityValue*)(malloc(sizeof(ProbabilityValue) * GRIDSIZE));
+        SeenGrid[i] = (char*)(malloc(sizeof(char) * GRIDSIZE));
+    }
+}
+
+/**
+ * Recomputes every unresolved cell from scratch into ReferenceGrid. The probability functions write to player->probabilityGrid, so it is
+ * swapped with the reference grid for the duration of the recompute.
+ */
+static void RecomputeReferenceGrid(Player * player){
+
+    ProbabilityValue ** incrementalGrid = player->probabilityGrid;
+    player->probabilityGrid = ReferenceGrid;
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            int cell[2] = {i, j};
+
+            ReferenceGrid[i][j] = 0;
+            if (CheckHitOrMiss(player->grid, cell)) continue;
+
+            CalcCutoffProb(player, cell);
+            CalcOverlapProb(player, cell);
+        }
+    }
+
+    player->probabilityGrid = incrementalGrid;
+}
+
+#pragma endregion
+
+#pragma region [COMPARISON]
+
+static void CompareGrids(Player * player, ConsistencyReport * report){
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            int cell[2] = {i, j};
+            if (CheckHitOrMiss(player->grid, cell) || IsStaleCell(player, i, j)) continue;
+
+            report->checkedCells++;
+
+            int difference = abs(player->probabilityGrid[i][j] - ReferenceGrid[i][j]);
+            if (difference == 0) continue;
+
+            report->staleCells++;
+            report->totalDifference += difference;
+            if (difference > report->maxDifference) report->maxDifference = difference;
+        }
+    }
+}
+
+/**
+ * Visits every cell of a region heap, marking the cells it finds in SeenGrid. A heap whose top is not its highest cell has a stale key too.
+ */
+static void CompareHeapNodes(Player * player, ProbabilityHeap * heap, ConsistencyReport * report){
+
+    int cells[PROB_REGION_WIDTH * PROB_REGION_HEIGHT];
+    int cellCount = ProbabilityHeapCells(player->probabilityNodes, heap, cells);
+
+    for (int k = 0; k < cellCount; k++)
+    {
+        int row = cells[k] / GRIDSIZE;
+        int col = cells[k] % GRIDSIZE;
+        ProbabilityValue probability = player->probabilityNodes[cells[k]].probability;
+
+        SeenGrid[row][col] = 1;
+
+        if (player->grid[row][col] == HIT || player->grid[row][col] == MISS) report->resolvedElements++;
+        else if (probability != player->probabilityGrid[row][col] || probability > heap->topProbability) report->staleKeys++;
+    }
+}
+
+/**
+ * Returns the category a non empty region heap belongs to, the same thresholds UpdateHeap() uses.
+ */
+static int ExpectedCategory(ProbabilityHeap * heap){
+
+    if (heap->topProbability >= HIGHPROB_BASE) return 2;
+    if (heap->topProbability >= AVGPROB_BASE) return 1;
+    return 0;
+}
+
+static void CompareHeaps(Player * player, ConsistencyReport * report){
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            SeenGrid[i][j] = 0;
+        }
+    }
+
+    for (int r = 0; r < PROB_REGION_COUNT; r++)
+    {
+        ProbabilityHeap * heap = &player->probabilityHeapSet[r];
+        int stale = player->staleRegions != NULL && player->staleRegions[r];
+
+        if (stale) report->staleRegions++;
+        else CompareHeapNodes(player, heap, report);
+
+        //A region must sit in exactly one category list, the one of its highest probability, or in none once emptied:
+        int listings = 0;
+        int listedCategory = -1;
+        D_ListNode * listedNode = NULL;
+
+        for (int c = 0; c < PROB_CATEGORYCOUNT; c++)
+        {
+            for (D_ListNode * curr = get_first(&player->probabilityHeapCategoryLists[c]); curr != NULL; curr = get_next(curr))
+            {
+                if ((ProbabilityHeap*)(get_data(curr)) != heap) continue;
+
+                listings++;
+                listedCategory = c;
+                listedNode = curr;
+            }
+        }
+
+        //FileProbabilityHeap() moves heaps by the list and node they record, so those must be where the heap really is:
+        if (heap->category != listedCategory || heap->categoryNode != listedNode){
+            report->misplacedRegions++;
+        }
+        else if (IsProbabilityHeapEmpty(heap)){
+            if (listings != 0) report->misplacedRegions++;
+        }
+        else if (listings != 1 || (!stale && listedCategory != ExpectedCategory(heap))){
+            report->misplacedRegions++;
+        }
+    }
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            int cell[2] = {i, j};
+            if (!SeenGrid[i][j] && ReferenceGrid[i][j] > 0 && IsHuntCell(player, i, j) && !CheckHitOrMiss(player->grid, cell) && !IsStaleCell(player, i, j)) report->missingCells++;
+        }
+    }
+}
+
+#pragma endregion
+
+#pragma region [REPORTING]
+
+static void WriteConsistencySummary(){
+
+    fprintf(ConsistencyOutput, "consistency: %d moves checked, %d diverged, %lld stale cells in total, largest difference %d\n",
+        MovesChecked, MovesDiverged, TotalStaleCells, WorstDifference);
+    fflush(ConsistencyOutput);
+}
+
+/**
+ * Writes to the BATTLESHIP_CONSISTENCY file if that variable is set, or to stderr. The summary is written at exit.
+ */
+static void InitializeConsistencyOutput(){
+
+    const char * path = getenv("BATTLESHIP_CONSISTENCY");
+    ConsistencyOutput = (path != NULL) ? fopen(path, "a") : NULL;
+
+    if (ConsistencyOutput == NULL) ConsistencyOutput = stderr;
+
+    atexit(WriteConsistencySummary);
+}
+
+void CheckProbabilityConsistency(Player * player){
+
+    if (player == NULL || player->probabilityGrid == NULL || player->probabilityHeapSet == NULL) return;
+
+    if (ReferenceGrid == NULL){
+        InitializeConsistencyGrids();
+        InitializeConsistencyOutput();
+    }
+
+    ConsistencyReport report = {0};
+
+    RecomputeReferenceGrid(player);
+    CompareGrids(player, &report);
+    CompareHeaps(player, &report);
+
+    MovesChecked++;
+    TotalStaleCells += report.staleCells;
+    if (report.maxDifference > WorstDifference) WorstDifference = report.maxDifference;
+
+    int diverged = report.staleCells + report.staleKeys + report.resolvedElements + report.missingCells + report.misplacedRegions > 0;
+    if (diverged) MovesDiverged++;
+
+    fprintf(ConsistencyOutput, "move %d against %s: grid %d/%d cells stale (max %d, mean %.2f) | heaps %d stale keys, %d resolved, %d missing, %d misplaced regions | %d lazy regions\n",
+        MovesChecked, player->name, report.staleCells, report.checkedCells, report.maxDifference,
+        (report.staleCells > 0) ? (double)report.totalDifference / (double)report.staleCells : 0.0,
+        report.staleKeys, report.resolvedElements, report.missingCells, report.misplacedRegions, report.staleRegions);
+}
+
+#pragma endregion
+
+#endif
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "D_LinkedList.h"
+#include "Memory.h"
 
 void initialize_empty_DList(D_LinkedList * list){
     if (list == NULL) return;
@@ -11,7 +12,7 @@ void initialize_empty_DList(D_LinkedList * list){
 }
 
 D_LinkedList* create_empty_Dlist() {
-    D_LinkedList * list = (D_LinkedList*)malloc(sizeof(D_LinkedList));
+    D_LinkedList * list = (D_LinkedList*)alloc_Tracked(MEM_LISTS, sizeof(D_LinkedList));
 
     if (list == NULL) {
         perror("Failed to allocate memory");
@@ -29,7 +30,7 @@ int is_empty(D_LinkedList* list) {
 }
 
 void addFirst(D_LinkedList* list, void* data) {
-    D_ListNode* new_node = (D_ListNode*)malloc(sizeof(D_ListNode));
+    D_ListNode* new_node = (D_ListNode*)alloc_Tracked(MEM_LISTS, sizeof(D_ListNode));
 
     if (new_node == NULL) {
         perror("Failed to allocate memory");
@@ -63,7 +64,7 @@ void* removeFirst(D_LinkedList* list) {
     else {
         list->tail = NULL;
     }
-    free(temp);
+    FreeTracked(temp);
 
     list->size--;
 
@@ -83,7 +84,7 @@ void* removeLast(D_LinkedList* list) {
     else {
         list->head = NULL;
     }
-    free(temp);
+    FreeTracked(temp);
 
     list->size--;
 
@@ -112,7 +113,7 @@ void* removeNode(D_LinkedList* list, D_ListNode* node) {
         list->tail = node->prev;
     }
 
-    free(node);
+    FreeTracked(node);
     list->size--;
 
     return data;
@@ -152,7 +153,7 @@ void* peek(D_LinkedList* list) {
 }
 
 void addLast(D_LinkedList* list, void* data) {
-    D_ListNode* new_node = (D_ListNode*)malloc(sizeof(D_ListNode));
+    D_ListNode* new_node = (D_ListNode*)alloc_Tracked(MEM_LISTS, sizeof(D_ListNode));
 
     if (new_node == NULL) {
         perror("Failed to allocate memory");
@@ -181,7 +182,7 @@ void free_D_LinkedList(D_LinkedList* list) {
     while (!is_empty(list)) {
         removeFirst(list);
     }
-    free(list);
+    FreeTracked(list);
 }
 
 //Below are iterator functions:
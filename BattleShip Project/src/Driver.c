@@ -1,5 +1,9 @@
 #include "../include/Driver.h"
 #include "../include/CalcProbs.h"
+#include "../include/Metrics.h"
+#include "../include/Trace.h"
+#include "../include/Memory.h"
+#include "../include/Consistency.h"
 
 int currPlayer;
 int currOpponent;
@@ -50,15 +54,18 @@ readoperation:
     if (operationIndex < 0 || strlen(operationStr) == 0)
     {
         if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, INVALID_OPERATION_WARNING);
+        FreeTracked(operationStr);
         return -1;
     }
 
-    free(operationStr);
+    FreeTracked(operationStr);
 
     char *coords = next(inputPtr);
 
     int res;
 
+    METRIC_TIMER_START(commandStart);
+
     switch (operationIndex)
     {
     case START:
@@ -79,14 +86,14 @@ readoperation:
         res = 3;
         break;
     case FIRE:
-        int fire = Fire(coords, playersArray[(currPlayer + 1) % PlayerCount]->grid, DifficultyValue, outputMsg);
+        int fire = Fire(coords, playersArray[currPlayer], playersArray[currOpponent], DifficultyValue, outputMsg);
         if (fire > 0)
             res = 4;
         else
             res = fire;
         break;
     case RADAR:
-        int radar = performRadarSweep(coords, playersArray[(currPlayer + 1) % PlayerCount], outputMsg);
+        int radar = performRadarSweep(coords, playersArray[currPlayer], playersArray[currOpponent], outputMsg);
         if (radar > 0)
             res = 5;
         else
@@ -116,7 +123,9 @@ readoperation:
         break;
     }
 
-    free(coords);
+    METRIC_TIMER_STOP(TIMER_COMMAND_FIRST + operationIndex, commandStart);
+
+    FreeTracked(coords);
     return res;
 
     // Map the operationStr to the right operation
@@ -135,7 +144,7 @@ void CheckForQuit(char *input)
     return;
 }
 
-int SetUpShip(int playerIndex, char *shipName, char shipChar, int shipWidth)
+int SetUpShip(int playerIndex, char *shipName, int shipID, int shipWidth)
 {
 
     char *input;
@@ -153,7 +162,7 @@ start:
 
     CheckForQuit(coords);
 
-    free(input);
+    FreeTracked(input);
 
     inpPtr = alloc_Input(REQUEST_ORIENTATION, &input);
 
@@ -161,7 +170,7 @@ start:
 
     CheckForQuit(orientation);
 
-    free(input);
+    FreeTracked(input);
 
     Player *player = playersArray[playerIndex];
 
@@ -169,16 +178,19 @@ start:
 
     char * outputMsg = NULL;
 
-    int placement = PlaceShipOnGridHelper(player, shipChar, (*player).grid, coords, orientation, shipSize, &outputMsg);
+    int placement = PlaceShipOnGridHelper(player, shipID, (*player).grid, coords, orientation, shipSize, &outputMsg);
+
+    FreeTracked(coords);
+    FreeTracked(orientation);
 
     if (placement < 0)
     {
         Println_Centered(outputMsg, strlen(outputMsg), RED);
-        if (outputMsg != NULL) free(outputMsg);
+        if (outputMsg != NULL) FreeTracked(outputMsg);
         goto start;
     }
 
-    if (outputMsg != NULL) free(outputMsg); //In case any function outputs a message (for debugging or whatever)
+    if (outputMsg != NULL) FreeTracked(outputMsg); //In case any function outputs a message (for debugging or whatever)
 
     return 1;
 }
@@ -201,8 +213,8 @@ void SetUpNewPlayer(int index)
         if (playersArray[i] != NULL){
             if (strcmp(playersArray[i]->name, name) == 0){
                 Println_Centered("Name is taken. Choose another name.", strlen("Name is taken. Choose another name."), RED);
-                free(input);
-                free(name);
+                FreeTracked(input);
+                FreeTracked(name);
                 goto playername;
             }
         }
@@ -212,41 +224,31 @@ void SetUpNewPlayer(int index)
 
     alloc_InitializePlayer(&(playersArray[index]), name, false, DUMB);
 
-    free(input);
-    free(name);    
-
-    RefreshScreen();
+    FreeTracked(input);
+    FreeTracked(name);    
 
-    Print_Centered("Set up ", strlen("Set up 's grid:") + strlen(playersArray[index]->name), WHITE);
-    PrintClr(playersArray[index]->name, playersArray[index]->UIColor);
-    PrintlnClr("'s grid:", WHITE);
-    
-    DisplayGrid(playersArray[index]->grid, GRIDSIZE);
-    SetUpShip(index, "Battleship", BATTLESHIP_C, BATTLESHIP_LENGTH);
+    Fleet * fleet = &playersArray[index]->fleet;
 
-    RefreshScreen();
-    Print_Centered("Set up ", strlen("Set up 's grid:") + strlen(playersArray[index]->name), WHITE);
-    PrintClr(playersArray[index]->name, playersArray[index]->UIColor);
-    PrintlnClr("'s grid:", WHITE);
+    //The classic fleet is set up in its usual order (Battleship, Carrier, Destroyer, Submarine). Other fleets go by ship ID:
+    static const int classicSetupOrder[SHIPCOUNT] = {BATTLESHIP_ID, CARRIER_ID, DESTROYER_ID, SUBMARINE_ID};
+    int classic = fleet->shipCount == SHIPCOUNT && fleet->length[CARRIER_ID] == CARRIER_LENGTH && fleet->length[BATTLESHIP_ID] == BATTLESHIP_LENGTH
+                  && fleet->length[DESTROYER_ID] == DESTROYER_LENGTH && fleet->length[SUBMARINE_ID] == SUBMARINE_LENGTH;
 
-    DisplayGrid(playersArray[index]->grid, GRIDSIZE);
-    SetUpShip(index, "Carrier", CARRIER_C, CARRIER_LENGTH);
+    //The player places every ship of the game's fleet, one after the other:
+    for (int i = 0; i < fleet->shipCount; i++)
+    {
+        int shipID = classic ? classicSetupOrder[i] : i + 1;
 
-    RefreshScreen();
-    Print_Centered("Set up ", strlen("Set up 's grid:") + strlen(playersArray[index]->name), WHITE);
-    PrintClr(playersArray[index]->name, playersArray[index]->UIColor);
-    PrintlnClr("'s grid:", WHITE);
+        RefreshScreen();
 
-    DisplayGrid(playersArray[index]->grid, GRIDSIZE);
-    SetUpShip(index, "Destroyer", DESTROYER_C, DESTROYER_LENGTH);
+        Print_Centered("Set up ", strlen("Set up 's grid:") + strlen(playersArray[index]->name), WHITE);
+        PrintClr(playersArray[index]->name, playersArray[index]->UIColor);
+        PrintlnClr("'s grid:", WHITE);
 
-    RefreshScreen();
-    Print_Centered("Set up ", strlen("Set up 's grid:") + strlen(playersArray[index]->name), WHITE);
-    PrintClr(playersArray[index]->name, playersArray[index]->UIColor);
-    PrintlnClr("'s grid:", WHITE);
+        DisplayGrid(playersArray[index]->grid, GRIDSIZE);
+        SetUpShip(index, ShipTypeName(fleet->length[shipID]), shipID, fleet->length[shipID]);
+    }
 
-    DisplayGrid(playersArray[index]->grid, GRIDSIZE);
-    SetUpShip(index, "Submarine", SUBMARINE_C, SUBMARINE_LENGTH);
     DisplayGrid(playersArray[index]->grid, GRIDSIZE);
 
     RefreshScreen();
@@ -272,7 +274,7 @@ void SetUpBot(int index){
     int isHard = strcmpi(input, "hard");
 
     if (isEasy != 0 && isHard != 0){
-        free(input);
+        FreeTracked(input);
         Println_Centered("Invalid input! Please enter a valid bot difficulty.", strlen("Invalid input! Please enter a valid bot difficulty."), RED);
         goto askBotDifficulty;
     }
@@ -282,11 +284,18 @@ void SetUpBot(int index){
 
     if (isHard == 0) botIQ = SMART;
 
-    alloc_InitializePlayer(&(playersArray[index]), "Botteyi", true, botIQ);
+    //Free-for-all games can have several bots, so they are numbered:
+    char botNumber[2] = {'1' + index, '\0'};
+    char * botName = (PlayerCount > 2) ? CreateString_alloc(2, "Botteyi ", botNumber) : CreateString_alloc(1, "Botteyi");
+
+    alloc_InitializePlayer(&(playersArray[index]), botName, true, botIQ);
+
+    FreeTracked(botName);
 
     printf("ali is ali\n");
 
-    PlaceBotShips(playersArray[index]);
+    //The players before this one are already set up:
+    PlaceBotShips(playersArray[index], playersArray, index);
     RefreshScreen();
 
 }
@@ -319,11 +328,97 @@ void ShowTurnStats(){
     Show_2_PlayerStats(playersArray[currPlayer % PlayerCount], playersArray[currOpponent % PlayerCount]);
 }
 
+/**
+ * Returns the index of the next player after index that is still in the game.
+ */
+int NextAlivePlayer(int index)
+{
+    for (int k = 1; k <= PlayerCount; k++)
+    {
+        int next = (index + k) % PlayerCount;
+
+        if (IsPlayerAlive(playersArray[next])) return next;
+    }
+
+    return index;
+}
+
+int CountAlivePlayers()
+{
+    int alive = 0;
+
+    for (int i = 0; i < PlayerCount; i++)
+    {
+        if (IsPlayerAlive(playersArray[i])) alive++;
+    }
+
+    return alive;
+}
+
+/**
+ * Picks who the current player attacks this turn. With two players it is always the other one. In free-for-all games bots pick their target
+ * with BotPickTarget() and humans are asked for the name of the player they want to attack.
+ */
+int PickOpponent()
+{
+    if (PlayerCount == 2) return (currPlayer + 1) % PlayerCount;
+
+    Player * player = playersArray[currPlayer];
+
+    if (player->isBot){
+        int target = BotPickTarget(player, playersArray, PlayerCount);
+
+        return (target >= 0) ? target : NextAlivePlayer(currPlayer);
+    }
+
+    Print_Centered("", strlen(player->name) + strlen("'s turn."), WHITE);
+    PrintClr(player->name, player->UIColor);
+    PrintlnClr("'s turn.", WHITE);
+
+    for (int i = 0; i < PlayerCount; i++)
+    {
+        if (i == currPlayer || !IsPlayerAlive(playersArray[i])) continue;
+
+        Println_Centered(playersArray[i]->name, strlen(playersArray[i]->name), playersArray[i]->UIColor);
+    }
+
+pickTarget:
+
+    char *input;
+    alloc_Input(REQUEST_TARGET, &input);
+
+    //Bot names hold a space ("Botteyi 2"), so the name is the whole line without its surrounding blanks:
+    char *name = input;
+    while (*name == ' ' || *name == '\t') name++;
+
+    int length = strlen(name);
+    while (length > 0 && (name[length - 1] == ' ' || name[length - 1] == '\t' || name[length - 1] == '\r')) length--;
+    name[length] = '\0';
+
+    CheckForQuit(name);
+
+    for (int i = 0; i < PlayerCount; i++)
+    {
+        if (i != currPlayer && IsPlayerAlive(playersArray[i]) && strcmp(playersArray[i]->name, name) == 0){
+            FreeTracked(input);
+            return i;
+        }
+    }
+
+    Println_Centered(INVALID_INPUT_WARNING, strlen(INVALID_INPUT_WARNING), RED);
+    FreeTracked(input);
+    goto pickTarget;
+}
+
 int PlayTurn()
 {
+    TRACE_SCOPE("PlayTurn");
+
     int showMiss = (DifficultyValue == 0) ? 1 : 0;
 
-    currOpponent = (currPlayer + 1) % PlayerCount;
+    METRICS_POLL();
+
+    currOpponent = PickOpponent();
 
     ShowTurnStats();
 
@@ -351,10 +446,10 @@ int PlayTurn()
 
             if (outputMsg != NULL){
                 Println_Centered(outputMsg, strlen(outputMsg), RED);//strlen breaks with NULL
-                free(outputMsg);
+                FreeTracked(outputMsg);
             }
             
-            free(input);
+            FreeTracked(input);
             goto startofoperation;
         }
 
@@ -372,13 +467,15 @@ int PlayTurn()
             DisplayOpponentGrid((playersArray[currOpponent])->grid, GRIDSIZE, showMiss);
         }
 
-        if (outputMsg != NULL) free(outputMsg);
-        free(input);
+        if (outputMsg != NULL) FreeTracked(outputMsg);
+        FreeTracked(input);
     }
     else {
 
         #pragma region [BOTS TURN]
 
+        METRIC_TIMER_START(moveStart);
+
         //Choose Bot attack depending on bot level:
         switch (playersArray[currPlayer % PlayerCount]->botIQ)
         {
@@ -391,6 +488,10 @@ int PlayTurn()
             break;
         }
 
+        METRIC_TIMER_STOP(TIMER_BOT_MOVE, moveStart);
+
+        CONSISTENCY_CHECK(playersArray[currOpponent]);
+
         RefreshScreen();
         ShowTurnStats();
         DisplayOpponentGrid((playersArray[currOpponent])->grid, GRIDSIZE, showMiss);
@@ -406,7 +507,15 @@ int PlayTurn()
     int oppSunkShips = countSunkShips(playersArray[currOpponent]);
 
     //If a player loses:
-    if (oppSunkShips == 4){
+    if (oppSunkShips == playersArray[currOpponent]->fleet.shipCount && CountAlivePlayers() > 1){
+
+        //In free-for-all games, the game goes on without the eliminated player:
+        char * out = CreateString_alloc(4, playersArray[currPlayer]->name, " sunk all of ", playersArray[currOpponent]->name, "'s ships! They are out of the game.");
+
+        Println_Centered(out, strlen(out), BLUE);
+        FreeTracked(out);
+    }
+    else if (oppSunkShips == playersArray[currOpponent]->fleet.shipCount){
 
         char * win = CreateString_alloc(4, playersArray[currPlayer]->name, " sunk all of ", playersArray[currOpponent]->name, "'s ships!");
 
@@ -416,9 +525,9 @@ int PlayTurn()
         char * congrats = CreateString_alloc(3, "Well done ", playersArray[currPlayer]->name, "!");
 
         Println_Centered(congrats, strlen(congrats), BLUE);
-        //free(input);
-        free(win);
-        free(congrats);
+        //FreeTracked(input);
+        FreeTracked(win);
+        FreeTracked(congrats);
         return -1;
     }
 
@@ -427,17 +536,19 @@ int PlayTurn()
     playersArray[currOpponent]->currSunkShips = oppSunkShips;
     
 
-    currPlayer = (currPlayer + 1) % PlayerCount;
+    currPlayer = NextAlivePlayer(currPlayer);
     
-    //if (outputMsg != NULL) free(outputMsg); //In case any function returns an output (Debug or whatever)
+    //if (outputMsg != NULL) FreeTracked(outputMsg); //In case any function returns an output (Debug or whatever)
 
-    //free(input);
+    //FreeTracked(input);
 
     return 1;
 }
 
 void RefreshScreen(){
 
+    TRACE_SCOPE("RefreshScreen");
+
     ClearScreen();
 
     SetBold();
@@ -450,6 +561,47 @@ void RefreshScreen(){
     Println("");
 }
 
+/**
+ * Frees every player of the game that ended and the players array, and records the human players' placements.
+ */
+void FreeGame(){
+
+    //The human players' placements and shots go to their profiles once nothing points into the profile store anymore:
+    for (int i = 0; i < PlayerCount; i++)
+    {
+        QueueProfile(playersArray[i]);
+    }
+
+    FreePlayerArray(playersArray, PlayerCount);
+    playersArray = NULL;
+
+    FlushProfiles();
+}
+
+/**
+ * Sets up the human players of indices [first, last). When bots will play, the starting probabilities they need are built on another
+ * thread in the meantime (see PrewarmProbabilityTemplate()), so the first bot does not make the game wait.
+ */
+void SetUpHumanPlayers(int first, int last, int withBots){
+
+    #pragma omp parallel sections num_threads(2) if (withBots)
+    {
+        #pragma omp section
+        {
+            for (int i = first; i < last; i++)
+            {
+                SetUpNewPlayer(i);
+                RefreshScreen();
+            }
+        }
+
+        #pragma omp section
+        {
+            if (withBots) PrewarmProbabilityTemplate();
+        }
+    }
+}
+
 void RunGame_PVP()
 {
     alloc_InitializePlayerArray(2, &playersArray);
@@ -474,18 +626,90 @@ startturn:
         char * input;
         char * inpPtr = alloc_Input(REQUEST_ANYKEY, &input);
 
-        free (input);
+        FreeTracked(input);
 
         RefreshScreen();
         goto startturn;
     }
 
-    for (int i = 0; i < PlayerCount; i++)
+    FreeGame();
+    return;
+}
+
+/**
+ * Free-for-all: up to MAXPLAYERCOUNT players, humans and bots, all against each other. Every turn the current player picks who to attack and
+ * players are eliminated once their whole fleet is sunk. The last player standing wins.
+ */
+void RunGame_FFA()
+{
+    char * input;
+    char * inpPtr;
+
+playercount:
+
+    inpPtr = alloc_Input(REQUEST_PLAYERCOUNT, &input);
+
+    char * countStr = next(&inpPtr);
+    CheckForQuit(countStr);
+
+    int playerCount = atoi(countStr);
+    FreeTracked(countStr);
+    FreeTracked(input);
+
+    if (playerCount < 2 || playerCount > MAXPLAYERCOUNT){
+        Println_Centered(INVALID_INPUT_WARNING, strlen(INVALID_INPUT_WARNING), RED);
+        goto playercount;
+    }
+
+botcount:
+
+    inpPtr = alloc_Input(REQUEST_BOTCOUNT, &input);
+
+    countStr = next(&inpPtr);
+    CheckForQuit(countStr);
+
+    int botCount = (strcmp(countStr, "0") == 0) ? 0 : atoi(countStr);
+    int isNumber = strlen(countStr) > 0 && (botCount > 0 || strcmp(countStr, "0") == 0);
+    FreeTracked(countStr);
+    FreeTracked(input);
+
+    if (!isNumber || botCount < 0 || botCount > playerCount){
+        Println_Centered(INVALID_INPUT_WARNING, strlen(INVALID_INPUT_WARNING), RED);
+        goto botcount;
+    }
+
+    PlayerCount = playerCount;
+
+    alloc_InitializePlayerArray(PlayerCount, &playersArray);
+
+    //Humans are set up first, then the bots:
+    SetUpHumanPlayers(0, PlayerCount - botCount, botCount > 0);
+
+    for (int i = PlayerCount - botCount; i < PlayerCount; i++)
     {
-        free(playersArray[i]);
+        SetUpBot(i);
+        RefreshScreen();
     }
 
-    free(playersArray);
+    Println_Centered(ANNOUNCE_RANDOMPLAYER, strlen(ANNOUNCE_RANDOMPLAYER), WHITE);
+
+    currPlayer = PickRandomPlayer(PlayerCount);
+
+startturn:
+
+    int turn = PlayTurn();
+
+    if (turn > 0)
+    {
+        inpPtr = alloc_Input(REQUEST_ANYKEY, &input);
+
+        FreeTracked(input);
+
+        RefreshScreen();
+        goto startturn;
+    }
+
+    FreeGame();
     return;
 }
 
@@ -496,8 +720,7 @@ void RunGame_PVE()
 
     //To make the game work for multiple players this initialization process should be changed:
         //Set Player:
-        SetUpNewPlayer(0);
-        RefreshScreen();
+        SetUpHumanPlayers(0, 1, 1);
         
         //Set Bot:
         SetUpBot(1);
@@ -519,18 +742,13 @@ startturn:
         char * input;
         char * inpPtr = alloc_Input(REQUEST_ANYKEY, &input);
 
-        free (input);
+        FreeTracked(input);
 
         RefreshScreen();
         goto startturn;
     }
 
-    for (int i = 0; i < PlayerCount; i++)
-    {
-        free(playersArray[i]);
-    }
-
-    free(playersArray);
+    FreeGame();
     return;
 }
 //
@@ -571,6 +789,9 @@ void Welcome()
 
 int main()
 {
+    METRICS_INITIALIZE();
+    TRACE_INITIALIZE();
+
     ClearScreen();
     Welcome();
 
@@ -586,11 +807,11 @@ start:
 
     if (op < 0)
     {
-        free(input);
+        FreeTracked(input);
         goto start;
     }
 
-    free(input);
+    FreeTracked(input);
 
     InstructionSet = PREGAMEINSTRUC;
 
@@ -607,12 +828,13 @@ setdifficulty:
     if (difficulty < 0)
     {
         Println_Centered(INVALID_INPUT_WARNING, strlen(INVALID_INPUT_WARNING), RED);
-        free(input);
+        FreeTracked(input);
+        FreeTracked(nextInp);
         goto setdifficulty;
     }
 
-    free(input);
-    free(nextInp);
+    FreeTracked(input);
+    FreeTracked(nextInp);
 
 selectgamemode:
 
@@ -627,12 +849,13 @@ selectgamemode:
     if (modeIndex < 0)
     {
         Println_Centered(INVALID_INPUT_WARNING, strlen(INVALID_INPUT_WARNING), RED);
-        free(input);
+        FreeTracked(input);
+        FreeTracked(nextInp);
         goto selectgamemode;
     }
 
-    free(input);
-    free(nextInp);
+    FreeTracked(input);
+    FreeTracked(nextInp);
 
     InstructionSet = INGAMEINSTRUC;
     switch (modeIndex)
@@ -647,6 +870,9 @@ selectgamemode:
 
         RunGame_PVE();
         break;
+    case FFA:
+        RunGame_FFA();
+        break;
     default:
         break;
     }
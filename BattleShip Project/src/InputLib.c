@@ -6,6 +6,7 @@
 #include "../include/Statements.h"
 #include "../include/ShortcutFuncs.h"
 #include "../include/UITools.h"
+#include "../include/Memory.h"
 
 char** InstructionSet;
 
@@ -66,7 +67,7 @@ char * alloc_IntegerToNumeral(int i, int maxInt, char startingChar, char endingC
     } while (k > 0);
     len++;
 
-    char * result = (char*)(malloc(sizeof(char) * len));
+    char * result = (char*)(alloc_Tracked(MEM_STRINGS, sizeof(char) * len));
 
     result[len - 1] = '\0';
 
@@ -103,8 +104,8 @@ char * alloc_GetCoordsFromIndices(int row, int col, int MaxInt, char startingCoo
     
     char * coords = CreateString_alloc(2, coords1, coords2);
 
-    free (coords1);
-    free(coords2);
+    FreeTracked(coords1);
+    FreeTracked(coords2);
 
     return coords;
 
@@ -122,7 +123,7 @@ char* next(char ** input){
     char *word;
 
     if ((*input)[0] == '\0'){
-        word = (char*)(malloc(sizeof(char)));
+        word = (char*)(alloc_Tracked(MEM_STRINGS, sizeof(char)));
         word[0] = '\0';
         return word;
     }
@@ -142,7 +143,7 @@ char* next(char ** input){
     }
     
     int wordLen = i + 2; //Extra spot for the null terminating character
-    word = (char*)(malloc(sizeof(char) * wordLen));
+    word = (char*)(alloc_Tracked(MEM_STRINGS, sizeof(char) * wordLen));
 
     for (int j = 0; j <= i; j++)
     {
@@ -174,7 +175,7 @@ char * alloc_Input(char * showMsg, char ** output){
     Print_Centered("> ", strlen(showMsg), WHITE);
     //printf("%s", showMsg);
 
-    char * inputRes = (char*)(malloc(sizeof(char) * MAXINPUTLENGTH));
+    char * inputRes = (char*)(alloc_Tracked(MEM_STRINGS, sizeof(char) * MAXINPUTLENGTH));
 
     
 
@@ -0,0 +1,68 @@
+#include "../include/MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * Maps a whole file read-only and stores its size. Returns NULL if the file can't be opened or is empty.
+ */
+const void * MapReadOnlyFile(const char * path, size_t * size){
+
+#ifdef _WIN32
+    //Other processes may append to the file or replace it while it is mapped:
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0){
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) return NULL;
+
+    //The view keeps the mapping alive after its handle is closed:
+    const void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    *size = (size_t)fileSize.QuadPart;
+    return view;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0){
+        close(fd);
+        return NULL;
+    }
+
+    void * view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return NULL;
+
+    *size = (size_t)info.st_size;
+    return view;
+#endif
+}
+
+void UnmapReadOnlyFile(const void * mapping, size_t size){
+
+    if (mapping == NULL) return;
+
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(mapping);
+#else
+    munmap((void*)mapping, size);
+#endif
+}
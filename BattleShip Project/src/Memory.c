@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "../include/Memory.h"
+
+/**
+ * Prepended to every tracked block. The union keeps the block that follows it aligned like malloc() would.
+ */
+typedef union MemoryHeader{
+    struct {
+        size_t size;
+        MemorySubsystem subsystem;
+    } info;
+    max_align_t alignment;
+} MemoryHeader;
+
+typedef struct MemoryCounters{
+    atomic_size_t inUse;
+    atomic_size_t peak;
+    atomic_size_t allocations;
+} MemoryCounters;
+
+static const char * MemorySubsystemNames[MEMSUBSYSTEMCOUNT] = {"players", "grids", "heaps", "lists", "tasks", "strings"};
+
+static MemoryCounters Counters[MEMSUBSYSTEMCOUNT];
+
+#pragma region [ALLOCATION]
+
+static void * TrackBlock(MemoryHeader * header, MemorySubsystem subsystem, size_t size){
+
+    if (header == NULL){
+        perror("Failed to allocate memory");
+        exit(EXIT_FAILURE);
+    }
+
+    header->info.size = size;
+    header->info.subsystem = subsystem;
+
+    MemoryCounters * counters = &Counters[subsystem];
+
+    size_t inUse = atomic_fetch_add_explicit(&counters->inUse, size, memory_order_relaxed) + size;
+    atomic_fetch_add_explicit(&counters->allocations, 1, memory_order_relaxed);
+
+    size_t peak = atomic_load_explicit(&counters->peak, memory_order_relaxed);
+    while (inUse > peak && !atomic_compare_exchange_weak_explicit(&counters->peak, &peak, inUse, memory_order_relaxed, memory_order_relaxed));
+
+    return header + 1;
+}
+
+void * alloc_Tracked(MemorySubsystem subsystem, size_t size){
+
+    return TrackBlock((MemoryHeader*)(malloc(sizeof(MemoryHeader) + size)), subsystem, size);
+}
+
+void * alloc_TrackedZeroed(MemorySubsystem subsystem, size_t count, size_t size){
+
+    return TrackBlock((MemoryHeader*)(calloc(1, sizeof(MemoryHeader) + count * size)), subsystem, count * size);
+}
+
+void FreeTracked(void * ptr){
+
+    if (ptr == NULL) return;
+
+    MemoryHeader * header = (MemoryHeader*)(ptr) - 1;
+
+    atomic_fetch_sub_explicit(&Counters[header->info.subsystem].inUse, header->info.size, memory_order_relaxed);
+
+    free(header);
+}
+
+#pragma endregion
+
+#pragma region [REPORTING]
+
+size_t MemoryInUse(MemorySubsystem subsystem){
+
+    return atomic_load(&Counters[subsystem].inUse);
+}
+
+size_t MemoryPeak(MemorySubsystem subsystem){
+
+    return atomic_load(&Counters[subsystem].peak);
+}
+
+size_t TotalMemoryInUse(){
+
+    size_t total = 0;
+
+    for (int i = 0; i < MEMSUBSYSTEMCOUNT; i++)
+    {
+        total += MemoryInUse((MemorySubsystem)i);
+    }
+
+    return total;
+}
+
+/**
+ * Sets every peak back to the current usage, so the peaks of the next game can be read on their own.
+ */
+void ResetMemoryPeaks(){
+
+    for (int i = 0; i < MEMSUBSYSTEMCOUNT; i++)
+    {
+        atomic_store(&Counters[i].peak, atomic_load(&Counters[i].inUse));
+    }
+}
+
+void PrintMemoryReport(FILE * out){
+
+    fprintf(out, "%-10s %14s %14s %14s\n", "subsystem", "in use (B)", "peak (B)", "allocations");
+
+    for (int i = 0; i < MEMSUBSYSTEMCOUNT; i++)
+    {
+        fprintf(out, "%-10s %14zu %14zu %14zu\n", MemorySubsystemNames[i], MemoryInUse((MemorySubsystem)i), MemoryPeak((MemorySubsystem)i),
+            atomic_load(&Counters[i].allocations));
+    }
+
+    fprintf(out, "%-10s %14zu\n", "total", TotalMemoryInUse());
+}
+
+#pragma endregion
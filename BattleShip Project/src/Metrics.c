@@ -0,0 +1,233 @@
+#include "../include/Metrics.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+/**
+ * Monotonic clock in nanoseconds. It is compiled in every build since the trace (Trace.c) uses it too.
+ */
+unsigned long long MetricsNow(){
+
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (unsigned long long)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+#ifdef ENABLE_METRICS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+
+/**
+ * Latencies are kept in power of two buckets: bucket b holds the samples in [2^b, 2^(b+1)) ns (bucket 0 also holds 0 ns). That is enough
+ * resolution to tell microseconds from milliseconds and recording a sample costs a few instructions.
+ */
+#define METRIC_BUCKETCOUNT 48
+
+typedef struct MetricHistogram{
+    unsigned long long count;
+    unsigned long long totalNs;
+    unsigned long long minNs;
+    unsigned long long maxNs;
+    unsigned long long buckets[METRIC_BUCKETCOUNT];
+} MetricHistogram;
+
+static const char * MetricTimerNames[METRICTIMERCOUNT] = {
+    "bot move", "bot opponent selection", "bot target selection", "bot task processing", "bot probability update", "bot heap refresh",
+    "command start", "command quit", "command next", "command fire", "command radar", "command smoke", "command artillery", "command torpedo"
+};
+
+static const char * MetricCounterNames[METRICCOUNTERCOUNT] = {
+    "cells recomputed", "heap inserts", "heap deletes", "allocations", "tasks queued", "transposition hits", "transposition misses", "regions refined"
+};
+
+atomic_ullong MetricCounters[METRICCOUNTERCOUNT];
+
+static MetricHistogram MetricHistograms[METRICTIMERCOUNT];
+
+static volatile sig_atomic_t MetricsDumpRequested = 0;
+
+#pragma region [RECORDING]
+
+void RecordMetricTime(MetricTimer timer, unsigned long long ns){
+
+    MetricHistogram * histogram = &MetricHistograms[timer];
+
+    int bucket = 0;
+    while (bucket < METRIC_BUCKETCOUNT - 1 && (ns >> (bucket + 1)) != 0) bucket++;
+
+    histogram->buckets[bucket]++;
+    histogram->totalNs += ns;
+
+    if (histogram->count == 0 || ns < histogram->minNs) histogram->minNs = ns;
+    if (ns > histogram->maxNs) histogram->maxNs = ns;
+
+    histogram->count++;
+}
+
+#pragma endregion
+
+#pragma region [SUMMARY]
+
+/**
+ * Prints a duration in the largest unit that keeps it above 1.
+ */
+static void PrintDuration(FILE * out, double ns){
+
+    if (ns >= 1e9) fprintf(out, "%8.2f s ", ns / 1e9);
+    else if (ns >= 1e6) fprintf(out, "%8.2f ms", ns / 1e6);
+    else if (ns >= 1e3) fprintf(out, "%8.2f us", ns / 1e3);
+    else fprintf(out, "%8.0f ns", ns);
+}
+
+/**
+ * Returns the upper bound of the bucket holding the given percentile, which is how precise a log2 histogram can be. It is clamped to the
+ * fastest and slowest samples.
+ */
+static double BucketPercentile(MetricHistogram * histogram, double percentile){
+
+    unsigned long long rank = (unsigned long long)(percentile * (double)histogram->count);
+    unsigned long long seen = 0;
+
+    for (int b = 0; b < METRIC_BUCKETCOUNT; b++)
+    {
+        seen += histogram->buckets[b];
+        if (seen > rank){
+            //Never report more than the slowest sample or less than the fastest:
+            unsigned long long bound = 1ULL << (b + 1);
+            if (bound > histogram->maxNs) bound = histogram->maxNs;
+            if (bound < histogram->minNs) bound = histogram->minNs;
+            return (double)bound;
+        }
+    }
+
+    return (double)histogram->maxNs;
+}
+
+void DumpMetrics(FILE * out){
+
+    fprintf(out, "\n==== Engine metrics ====\n\nCounters:\n");
+
+    for (int c = 0; c < METRICCOUNTERCOUNT; c++)
+    {
+        fprintf(out, "  %-24s %16llu\n", MetricCounterNames[c], atomic_load(&MetricCounters[c]));
+    }
+
+    fprintf(out, "\nTimings (p50/p90/p99 are bucket upper bounds):\n");
+
+    for (int t = 0; t < METRICTIMERCOUNT; t++)
+    {
+        MetricHistogram * histogram = &MetricHistograms[t];
+
+        if (histogram->count == 0) continue;
+
+        fprintf(out, "  %s: %llu samples\n    mean ", MetricTimerNames[t], histogram->count);
+        PrintDuration(out, (double)histogram->totalNs / (double)histogram->count);
+        fprintf(out, "  min ");
+        PrintDuration(out, (double)histogram->minNs);
+        fprintf(out, "  p50 ");
+        PrintDuration(out, BucketPercentile(histogram, 0.50));
+        fprintf(out, "  p90 ");
+        PrintDuration(out, BucketPercentile(histogram, 0.90));
+        fprintf(out, "  p99 ");
+        PrintDuration(out, BucketPercentile(histogram, 0.99));
+        fprintf(out, "  max ");
+        PrintDuration(out, (double)histogram->maxNs);
+        fprintf(out, "\n");
+
+        for (int b = 0; b < METRIC_BUCKETCOUNT; b++)
+        {
+            if (histogram->buckets[b] == 0) continue;
+
+            fprintf(out, "    < ");
+            PrintDuration(out, (double)(1ULL << (b + 1)));
+            fprintf(out, " %10llu ", histogram->buckets[b]);
+
+            int bar = (int)(40 * histogram->buckets[b] / histogram->count);
+            for (int i = 0; i < bar; i++) fputc('#', out);
+            fputc('\n', out);
+        }
+    }
+
+    fprintf(out, "\n");
+    fflush(out);
+}
+
+/**
+ * Writes the summary to the BATTLESHIP_METRICS file if that variable is set, or to stderr.
+ */
+static void DumpMetricsToDestination(){
+
+    const char * path = getenv("BATTLESHIP_METRICS");
+    FILE * out = (path != NULL) ? fopen(path, "a") : NULL;
+
+    DumpMetrics((out != NULL) ? out : stderr);
+
+    if (out != NULL) fclose(out);
+}
+
+#pragma endregion
+
+#pragma region [TRIGGERS]
+
+/**
+ * The process is on its way out, so the summary is written right away before the default handler terminates it.
+ */
+static void HandleTerminationSignal(int sig){
+
+    DumpMetricsToDestination();
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/**
+ * The game keeps running, so the summary is only requested here and written by PollMetricsDump() at the start of the next turn.
+ */
+static void HandleDumpSignal(int sig){
+
+    MetricsDumpRequested = 1;
+    signal(sig, HandleDumpSignal);
+}
+
+void PollMetricsDump(){
+
+    if (!MetricsDumpRequested) return;
+
+    MetricsDumpRequested = 0;
+    DumpMetricsToDestination();
+}
+
+void InitializeMetrics(){
+
+    atexit(DumpMetricsToDestination);
+
+    signal(SIGINT, HandleTerminationSignal);
+    signal(SIGTERM, HandleTerminationSignal);
+
+#ifdef SIGUSR1
+    signal(SIGUSR1, HandleDumpSignal);
+#endif
+#ifdef SIGBREAK
+    signal(SIGBREAK, HandleDumpSignal);
+#endif
+}
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/OpeningBook.h"
+#include "../include/Player.h"
+#include "../include/CalcProbs.h"
+#include "../include/ShipPlacement.h"
+#include "../include/Memory.h"
+#include "../include/MappedFile.h"
+#include "../include/Transposition.h"
+
+#define OPENINGBOOK_MAGIC "BSBOOK\0\0"
+
+/**
+ * Layout of a book file: this header, then afloatByLength (maxLength + 1 ints), then the starting grid (GRIDSIZE * GRIDSIZE ints, row by
+ * row), then the lines (lineCount * lineLength cell indices, row * GRIDSIZE + col). Every field is an int or wider, so the sections that
+ * follow the header stay aligned in the mapping.
+ */
+typedef struct OpeningBookHeader{
+    char magic[8];
+    unsigned long long key;
+    int version;
+    int gridSize;
+    int maxLength;
+    int fleetCells;
+    int lineCount;
+    int lineLength;
+} OpeningBookHeader;
+
+/**
+ * The book mapped by this process. Only one configuration is played at a time, so asking for another one unmaps it first.
+ */
+typedef struct OpeningBook{
+    const void * mapping;
+    size_t size;
+    unsigned long long key;
+    const OpeningBookHeader * header;
+    const int * grid;
+    const int * lines;
+} OpeningBook;
+
+static OpeningBook LoadedBook = {NULL, 0, 0, NULL, NULL, NULL};
+
+//Set once a lookup for the current key found no usable book, so it is not looked for again on every player:
+static unsigned long long MissingBookKey = 0;
+
+#pragma region [CONFIGURATION]
+
+/**
+ * FNV-1a over the grid size, the book version and the number of ships of each length. The order of the ships does not change the
+ * probabilities, so it is left out of the key.
+ */
+static unsigned long long FleetKey(int maxLength, const int * afloatByLength){
+
+    unsigned long long hash = 14695981039346656037ULL;
+    int fields[3] = {GRIDSIZE, OPENINGBOOK_VERSION, maxLength};
+
+    for (int i = 0; i < 3; i++)
+    {
+        hash = (hash ^ (unsigned long long)(unsigned int)fields[i]) * 1099511628211ULL;
+    }
+
+    for (int length = 1; length <= maxLength; length++)
+    {
+        hash = (hash ^ (unsigned long long)(unsigned int)afloatByLength[length]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static char * alloc_BookPath(const char * directory, unsigned long long key){
+
+    char * path = (char*)(alloc_Tracked(MEM_STRINGS, strlen(directory) + 64));
+    sprintf(path, "%s/opening_%d_%016llx.book", directory, GRIDSIZE, key);
+
+    return path;
+}
+
+static const char * BookDirectory(){
+
+    const char * directory = getenv("BATTLESHIP_BOOK_DIR");
+    return (directory != NULL) ? directory : "books";
+}
+
+static size_t BookSize(int maxLength, int lineCount, int lineLength){
+
+    return sizeof(OpeningBookHeader) + sizeof(int) * ((size_t)(maxLength + 1) + (size_t)GRIDSIZE * GRIDSIZE + (size_t)lineCount * lineLength);
+}
+
+#pragma endregion
+
+#pragma region [LOADING]
+
+void CloseOpeningBook(){
+
+    if (LoadedBook.mapping != NULL) UnmapReadOnlyFile(LoadedBook.mapping, LoadedBook.size);
+
+    memset(&LoadedBook, 0, sizeof(OpeningBook));
+}
+
+/**
+ * Returns the book of the fleet's configuration, mapping it if needed, or NULL if there is none. A file that does not describe exactly
+ * this configuration (other version, grid size or fleet, or truncated) is ignored.
+ */
+static const OpeningBook * FindOpeningBook(Fleet * fleet){
+
+    unsigned long long key = FleetKey(fleet->maxLength, fleet->afloatByLength);
+
+    if (LoadedBook.mapping != NULL && LoadedBook.key == key) return &LoadedBook;
+    if (MissingBookKey == key) return NULL;
+
+    CloseOpeningBook();
+
+    char * path = alloc_BookPath(BookDirectory(), key);
+    size_t size = 0;
+    const void * mapping = MapReadOnlyFile(path, &size);
+    FreeTracked(path);
+
+    const OpeningBookHeader * header = (const OpeningBookHeader*)(mapping);
+
+    int valid = mapping != NULL && size >= sizeof(OpeningBookHeader) && memcmp(header->magic, OPENINGBOOK_MAGIC, 8) == 0
+        && header->key == key && header->version == OPENINGBOOK_VERSION && header->gridSize == GRIDSIZE
+        && header->maxLength == fleet->maxLength && header->lineCount >= 0 && header->lineLength >= 0
+        && size >= BookSize(header->maxLength, header->lineCount, header->lineLength);
+
+    //The key is a hash, so the fleet itself is compared too:
+    const int * afloatByLength = (const int*)(header + 1);
+    for (int length = 0; valid && length <= fleet->maxLength; length++)
+    {
+        valid = (afloatByLength[length] == fleet->afloatByLength[length]);
+    }
+
+    if (!valid){
+        if (mapping != NULL) UnmapReadOnlyFile(mapping, size);
+        MissingBookKey = key;
+        return NULL;
+    }
+
+    LoadedBook.mapping = mapping;
+    LoadedBook.size = size;
+    LoadedBook.key = key;
+    LoadedBook.header = header;
+    LoadedBook.grid = afloatByLength + fleet->maxLength + 1;
+    LoadedBook.lines = LoadedBook.grid + GRIDSIZE * GRIDSIZE;
+
+    return &LoadedBook;
+}
+
+#pragma endregion
+
+#pragma region [LOOKUPS]
+
+/**
+ * Fills the player's probability grid (already allocated) from the book of its fleet. Returns 1 if it did, 0 if there is no book, in which
+ * case the grid must be computed.
+ */
+int LoadOpeningGrid(Player * player){
+
+    //The book is computed without any prior:
+    if (player->placementPrior != NULL) return 0;
+
+    const OpeningBook * book = FindOpeningBook(&player->fleet);
+    if (book == NULL) return 0;
+
+    //The book keeps 32-bit values, the grid is narrower (see ProbabilityHeap.h):
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            player->probabilityGrid[i][j] = ToProbabilityValue(book->grid[(size_t)i * GRIDSIZE + j]);
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Gives the bot's next opening shot against the opponent in row and col. Returns 1 if it did, 0 once the bot is out of the book: the
+ * opponent was already hit (the lines assume every shot missed), its fleet has no book, or the bot's line is over. Cells that were
+ * already shot (by this bot or by anyone else in free-for-all games) are skipped.
+ */
+int NextOpeningShot(Player * bot, Player * opponent, int * row, int * col){
+
+    //The lines are not worth playing against a player whose habits are known:
+    if (opponent->placementPrior != NULL) return 0;
+
+    const OpeningBook * book = FindOpeningBook(&opponent->fleet);
+
+    if (book == NULL || book->header->lineCount == 0 || opponent->fleet.unhitCells != book->header->fleetCells) return 0;
+
+    if (bot->openingLine < 0 || bot->openingLine >= book->header->lineCount){
+        bot->openingLine = rand() % book->header->lineCount;
+        bot->openingMove = 0;
+    }
+
+    const int * line = book->lines + (size_t)bot->openingLine * book->header->lineLength;
+
+    while (bot->openingMove < book->header->lineLength)
+    {
+        int cell = line[bot->openingMove++];
+        int r = cell / GRIDSIZE;
+        int c = cell % GRIDSIZE;
+
+        if (opponent->grid[r][c] == HIT || opponent->grid[r][c] == MISS) continue;
+
+        *row = r;
+        *col = c;
+        return 1;
+    }
+
+    return 0;
+}
+
+#pragma endregion
+
+#pragma region [GENERATION]
+
+/**
+ * Picks the next shot of a line: a random cell among the unshot ones whose probability is at least OPENINGBOOK_CANDIDATE_PERCENT of the
+ * highest. Returns the cell index, or -1 if every cell was shot.
+ */
+static int PickOpeningCell(Player * scratch, unsigned long long * rngState){
+
+    long long cutoff = 0;
+    int candidates = 0;
+
+    //Lines that shot the same cells in another order, and the first shot of every line, find their candidates in the cache:
+    unsigned long long cached;
+    if (ProbeTransposition(scratch, TT_OPENING_CUTOFF, OPENINGBOOK_CANDIDATE_PERCENT, &cached)){
+        cutoff = (long long)(int)(cached >> 32);
+        candidates = (int)(cached & 0xFFFFFFFFULL);
+        goto pickCandidate;
+    }
+
+    int highest = -1;
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            if (scratch->grid[i][j] != MISS && scratch->probabilityGrid[i][j] > highest) highest = scratch->probabilityGrid[i][j];
+        }
+    }
+
+    if (highest < 0) return -1;
+
+    cutoff = ((long long)highest * OPENINGBOOK_CANDIDATE_PERCENT + 99) / 100;
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            if (scratch->grid[i][j] != MISS && scratch->probabilityGrid[i][j] >= cutoff) candidates++;
+        }
+    }
+
+    StoreTransposition(scratch, TT_OPENING_CUTOFF, OPENINGBOOK_CANDIDATE_PERCENT, ((unsigned long long)(unsigned int)cutoff << 32) | (unsigned int)candidates);
+
+    pickCandidate:;
+
+    int pick = (int)(NextPlacementRandom(rngState) % (unsigned long long)candidates);
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            if (scratch->grid[i][j] != MISS && scratch->probabilityGrid[i][j] >= cutoff && pick-- == 0) return i * GRIDSIZE + j;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Computes the book of the given fleet with the probability functions of CalcProbs.c, on a scratch player that only has a grid, a
+ * probability grid and a fleet, and writes it to the directory. It is written to a temporary file first and renamed, so a game mapping the
+ * book at the same time never sees it half written. Returns 1 on success and -1 if the file could not be written. If outputPath is not
+ * NULL, it receives the path of the book (freed with FreeTracked()).
+ */
+int WriteOpeningBook(const char * directory, const int * shipLengths, int shipCount, unsigned long long seed, char ** outputPath){
+
+    Player scratch;
+    memset(&scratch, 0, sizeof(Player));
+
+    InitializeFleet(&scratch.fleet, shipLengths, shipCount);
+
+    scratch.grid = (char**)(alloc_Tracked(MEM_GRIDS, sizeof(char*) * GRIDSIZE));
+    scratch.probabilityGrid = alloc_ProbabilityGrid();
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        scratch.grid[i] = (char*)(alloc_Tracked(MEM_GRIDS, sizeof(char) * GRIDSIZE));
+    }
+
+    OpeningBookHeader header;
+    memset(&header, 0, sizeof(OpeningBookHeader));
+    memcpy(header.magic, OPENINGBOOK_MAGIC, 8);
+    header.key = FleetKey(scratch.fleet.maxLength, scratch.fleet.afloatByLength);
+    header.version = OPENINGBOOK_VERSION;
+    header.gridSize = GRIDSIZE;
+    header.maxLength = scratch.fleet.maxLength;
+    header.fleetCells = scratch.fleet.unhitCells;
+    header.lineCount = OPENINGBOOK_LINECOUNT;
+    header.lineLength = MIN(OPENINGBOOK_LINELENGTH, GRIDSIZE * GRIDSIZE);
+
+    int * grid = (int*)(alloc_Tracked(MEM_GRIDS, sizeof(int) * GRIDSIZE * GRIDSIZE));
+    int * lines = (int*)(alloc_Tracked(MEM_GRIDS, sizeof(int) * header.lineCount * header.lineLength));
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            int cell[2] = {i, j};
+            CalcCutoffProb(&scratch, cell);
+            grid[i * GRIDSIZE + j] = scratch.probabilityGrid[i][j];
+        }
+    }
+
+    unsigned long long rngState = seed;
+
+    for (int l = 0; l < header.lineCount; l++)
+    {
+        for (int i = 0; i < GRIDSIZE; i++)
+        {
+            memset(scratch.grid[i], WATER_C, GRIDSIZE);
+
+            for (int j = 0; j < GRIDSIZE; j++)
+            {
+                scratch.probabilityGrid[i][j] = ToProbabilityValue(grid[i * GRIDSIZE + j]);
+            }
+        }
+        scratch.knowledgeHash = InitialKnowledgeHash(&scratch.fleet);
+
+        for (int s = 0; s < header.lineLength; s++)
+        {
+            int cell = PickOpeningCell(&scratch, &rngState);
+            lines[l * header.lineLength + s] = cell;
+
+            int target[2] = {cell / GRIDSIZE, cell % GRIDSIZE};
+            scratch.grid[target[0]][target[1]] = MISS;
+            scratch.knowledgeHash ^= ZobristCellKey(target[0], target[1], MISS);
+            UpdateSurroundingProbabilities(&scratch, target);
+        }
+    }
+
+    char * path = alloc_BookPath(directory, header.key);
+    char * tempPath = CreateString_alloc(2, path, ".tmp");
+
+    FILE * out = fopen(tempPath, "wb");
+    int written = out != NULL
+        && fwrite(&header, sizeof(OpeningBookHeader), 1, out) == 1
+        && fwrite(scratch.fleet.afloatByLength, sizeof(int), header.maxLength + 1, out) == (size_t)(header.maxLength + 1)
+        && fwrite(grid, sizeof(int), GRIDSIZE * GRIDSIZE, out) == (size_t)(GRIDSIZE * GRIDSIZE)
+        && fwrite(lines, sizeof(int), header.lineCount * header.lineLength, out) == (size_t)(header.lineCount * header.lineLength);
+
+    if (out != NULL && fclose(out) != 0) written = 0;
+
+    //rename() does not replace an existing file on Windows:
+    remove(path);
+    if (written && rename(tempPath, path) != 0) written = 0;
+    if (!written) remove(tempPath);
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        FreeTracked(scratch.grid[i]);
+    }
+    FreeTracked(scratch.grid);
+    FreeProbabilityGrid(scratch.probabilityGrid);
+    FreeTracked(grid);
+    FreeTracked(lines);
+    FreeTracked(tempPath);
+    FreeFleet(&scratch.fleet);
+
+    if (outputPath != NULL) *outputPath = path;
+    else FreeTracked(path);
+
+    return written ? 1 : -1;
+}
+
+#pragma endregion
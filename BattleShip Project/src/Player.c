@@ -2,6 +2,11 @@
 #include "../include/ShipPlacement.h"
 #include "../include/Bot.h"
 #include "../include/CalcProbs.h"
+#include "../include/Metrics.h"
+#include "../include/Trace.h"
+#include "../include/Memory.h"
+#include "../include/OpeningBook.h"
+#include "../include/Transposition.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,13 +17,29 @@ char * PlayerColors[playerColorCount] = {RED, GREEN, YELLOW, BLUE, MAGENTA};
 
 
 Player ** alloc_InitializePlayerArray(int playerCount, Player *** playersArray){
-    *playersArray = (Player**)(malloc(sizeof(Player*) * playerCount));
+    *playersArray = (Player**)(alloc_Tracked(MEM_PLAYERS, sizeof(Player*) * playerCount));
 
     for (int i = 0; i < playerCount; i++)
     {
         (*playersArray)[i] = NULL;
     }
     
+    return *playersArray;
+}
+
+/**
+ * Frees every player of the array (NULL slots are skipped) and the array itself.
+ */
+void FreePlayerArray(Player ** players, int playerCount){
+
+    if (players == NULL) return;
+
+    for (int i = 0; i < playerCount; i++)
+    {
+        FreePlayer(players[i]);
+    }
+
+    FreeTracked(players);
 }
 
 /**
@@ -30,18 +51,18 @@ Player* alloc_InitializePlayer(Player** output, char* playerName, int isBot, Bot
     
     
 
-    *output = (Player *)(malloc(sizeof(Player)));
+    *output = (Player *)(alloc_Tracked(MEM_PLAYERS, sizeof(Player)));
 
     //Initialize Grid and name:
 
-    (*output)->name = (char*)(malloc(sizeof(char) * MAXINPUTLENGTH));
+    (*output)->name = (char*)(alloc_Tracked(MEM_STRINGS, sizeof(char) * MAXINPUTLENGTH));
 
     strcpy((*output)->name, playerName);
 
-    (*output)->grid = (char**)(malloc(sizeof(char*) * GRIDSIZE));
+    (*output)->grid = (char**)(alloc_Tracked(MEM_GRIDS, sizeof(char*) * GRIDSIZE));
     for (int i = 0; i < GRIDSIZE; i++)
     {
-        ((*output)->grid)[i] = (char*)(malloc(sizeof(char) * GRIDSIZE));
+        ((*output)->grid)[i] = (char*)(alloc_Tracked(MEM_GRIDS, sizeof(char) * GRIDSIZE));
     }
 
     for (int i = 0; i < GRIDSIZE; i++)
@@ -53,21 +74,47 @@ Player* alloc_InitializePlayer(Player** output, char* playerName, int isBot, Bot
         
     }
     
+    (*output)->shipIdGrid = (unsigned char**)(alloc_Tracked(MEM_GRIDS, sizeof(unsigned char*) * GRIDSIZE));
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        (*output)->shipIdGrid[i] = (unsigned char*)(alloc_TrackedZeroed(MEM_GRIDS, GRIDSIZE, sizeof(unsigned char)));
+    }
+
     //initializing artilleryused, smokegrid, and torpedoused to false
 
-    (*output)->smokeGrid = (bool**)(malloc(sizeof(bool*) * GRIDSIZE));
+    (*output)->smokeGrid = (bool**)(alloc_Tracked(MEM_GRIDS, sizeof(bool*) * GRIDSIZE));
     for (int i = 0; i < GRIDSIZE; i++) {
-        (*output)->smokeGrid[i] = (bool*)malloc(sizeof(bool) * GRIDSIZE);
+        (*output)->smokeGrid[i] = (bool*)alloc_Tracked(MEM_GRIDS, sizeof(bool) * GRIDSIZE);
         for (int j = 0; j < GRIDSIZE; j++) {
             (*output)->smokeGrid[i][j] = false; // initializing each cell to false
         }
     }
     
-    (*output)->usedsmokes = 0;
-    // Initialize sweepsLeft to 3
-    (*output)->sweepsLeft = 3;
+    InitializeRadarAreaTable(*output);
+
+    for (int i = 0; i < WEAPONCOUNT; i++)
+    {
+        (*output)->weaponUses[i] = 0;
+    }
+
+    (*output)->earlyShots = isBot ? NULL : (int*)(alloc_Tracked(MEM_PLAYERS, sizeof(int) * PROFILE_EARLYSHOTS));
+    (*output)->earlyShotCount = 0;
+
+    for (int i = 0; i < MAXOPPONENTCOUNT; i++)
+    {
+        (*output)->hiddenMissTargets[i] = NULL;
+        (*output)->hiddenMisses[i] = NULL;
+        (*output)->hiddenMissCount[i] = 0;
+    }
     (*output)->prevSunk = 0;
     (*output)->currSunkShips = 0;
+    (*output)->sunkShipCount = 0;
+    (*output)->enemyShipsSunk = 0;
+    (*output)->resolvedCells = 0;
+
+    //Ships are not placed yet, so their bounds and hit counters start empty:
+    InitializeFleet(&(*output)->fleet, GameShipLengths, GameShipCount);
+    (*output)->knowledgeHash = InitialKnowledgeHash(&(*output)->fleet);
 
 
 
@@ -80,22 +127,28 @@ Player* alloc_InitializePlayer(Player** output, char* playerName, int isBot, Bot
     (*output)->botIQ = botIQ;
 
 
-    //Initialize the probability distribution grid:
-    InitializeProbabilities(*output);
-
-    DisplayIntGrid((*output)->probabilityGrid, GRIDSIZE);
+    //Known players are expected to place their ships where they usually do:
+    (*output)->placementPrior = isBot ? NULL : alloc_PlacementPrior(*output);
 
-    InitializeProbabilityHeaps(*output);
+    //The probability grid and heaps are only built when a bot needs them (see AcquireProbabilityState()), so creating a player stays cheap
+    //and a player no bot ever targets never pays for them:
+    (*output)->probabilityGrid = NULL;
+    (*output)->staleRegions = NULL;
+    (*output)->probabilityHeapSet = NULL;
+    (*output)->probabilityNodes = NULL;
+    (*output)->probabilityHeapCategoryLists = NULL;
+    (*output)->probabilityTemplate = NULL;
+    (*output)->huntStride = 1;
+    (*output)->huntOffset = 0;
     //printf("adsff\n");
 
-    if (isBot == 1){
-
-        //If Bot: Initialize Bot Stack Memory:
-        InitializeBotStackMemory(*output);
-    }
+    InitializeBotStackMemory(*output);
 
     (*output)->currTargetCategory = PROB_CATEGORYCOUNT - 1;
 
+    (*output)->openingLine = -1;
+    (*output)->openingMove = 0;
+
 
 
     //Initializing Risk Factor:
@@ -104,21 +157,116 @@ Player* alloc_InitializePlayer(Player** output, char* playerName, int isBot, Bot
     return *output;
 }
 
+/**
+ * Frees everything alloc_InitializePlayer() allocated and everything the player gathered during the game (bot tasks included).
+ */
+void FreePlayer(Player * player){
+
+    if (player == NULL) return;
+
+    if (player->isBot) FreeBotStackMemory(player);
+
+    FreeProbabilityState(player);
+    FreeTracked(player->placementPrior);
+    FreeTracked(player->earlyShots);
+
+    for (int i = 0; i < MAXOPPONENTCOUNT; i++)
+    {
+        FreeTracked(player->hiddenMisses[i]);
+    }
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        FreeTracked(player->grid[i]);
+        FreeTracked(player->shipIdGrid[i]);
+        FreeTracked(player->smokeGrid[i]);
+    }
+
+    for (int i = 0; i <= GRIDSIZE; i++)
+    {
+        FreeTracked(player->radarAreaTable[i]);
+    }
+
+    FreeTracked(player->grid);
+    FreeTracked(player->shipIdGrid);
+    FreeTracked(player->smokeGrid);
+    FreeTracked(player->radarAreaTable);
+
+    FreeFleet(&player->fleet);
+
+    FreeTracked(player->name);
+    FreeTracked(player);
+}
+
 #pragma region [PROBABILITY INITIALIZATION]
 
 /**
- * This function passes over the entire grid and calculates the starting probabilities of each cell.
+ * Allocates a zeroed GRIDSIZE x GRIDSIZE probability grid. The rows are one block behind the row pointers, so the whole grid is two
+ * allocations and neighbouring rows are next to each other in memory. Freed with FreeProbabilityGrid().
  */
-int InitializeProbabilities(Player * player){
+ProbabilityValue ** alloc_ProbabilityGrid(void){
 
-    player->probabilityGrid = (int**)(malloc(sizeof(int*) * GRIDSIZE));
+    ProbabilityValue ** grid = (ProbabilityValue**)(alloc_Tracked(MEM_GRIDS, sizeof(ProbabilityValue*) * GRIDSIZE));
+    ProbabilityValue * cells = (ProbabilityValue*)(alloc_TrackedZeroed(MEM_GRIDS, (size_t)GRIDSIZE * GRIDSIZE, sizeof(ProbabilityValue)));
 
     for (int i = 0; i < GRIDSIZE; i++)
     {
-        player->probabilityGrid[i] = (int*)(malloc(sizeof(int) * GRIDSIZE));
+        grid[i] = cells + (size_t)i * GRIDSIZE;
     }
 
-    //I need to calculate the cutoff probability for each square on the grid:
+    return grid;
+}
+
+void FreeProbabilityGrid(ProbabilityValue ** grid){
+
+    if (grid == NULL) return;
+
+    FreeTracked(grid[0]);
+    FreeTracked(grid);
+}
+
+/**
+ * Returns 1 if no cell of the player's grid was shot yet, so its probabilities are still those of a blank board.
+ */
+static int IsUntouched(Player * player){
+
+    return player->resolvedCells == 0 && player->sunkShipCount == 0;
+}
+
+/**
+ * This function passes over the entire grid and calculates the starting probabilities of each cell. A player that was already shot at (by
+ * humans, in free-for-all games) gets them computed from its grid.
+ */
+int InitializeProbabilities(Player * player){
+
+    TRACE_SCOPE("InitializeProbabilities");
+
+    //Zeroed, since on lazy boards the cells that were never evaluated are still read by PickHuntOffset():
+    player->probabilityGrid = alloc_ProbabilityGrid();
+
+    player->staleRegions = NULL;
+
+    //The starting grid only depends on the grid size and the fleet, so it is copied from the opening book when there is one:
+    if (IsUntouched(player) && LoadOpeningGrid(player) > 0) return 1;
+
+    //On lazy boards, every region waits for a query to compute its cells (see PROB_LAZY_MINCELLS):
+    if (GRIDSIZE * GRIDSIZE >= PROB_LAZY_MINCELLS){
+        int regionCount = PROB_REGION_COUNT;
+
+        player->staleRegions = (unsigned char*)(alloc_Tracked(MEM_GRIDS, sizeof(unsigned char) * regionCount));
+        memset(player->staleRegions, 1, sizeof(unsigned char) * regionCount);
+
+        return 1;
+    }
+
+    //Hits and misses change the cells around them, so every cell is computed like after a sink:
+    if (!IsUntouched(player)){
+        int wholeGrid[4] = {0, GRIDSIZE - 1, 0, GRIDSIZE - 1};
+        return UpdateRegionProbabilities(player, wholeGrid);
+    }
+
+    //I need to calculate the cutoff probability for each square on the grid (in row bands, see PROB_PARALLEL_MINCELLS):
+    #pragma omp parallel for schedule(static) if (GRIDSIZE * GRIDSIZE >= PROB_PARALLEL_MINCELLS)
     for (int i = 0; i < GRIDSIZE; i++)
     {
         for (int j = 0; j < GRIDSIZE; j++)
@@ -128,199 +276,692 @@ int InitializeProbabilities(Player * player){
         }
         
     }
-    
-    return 1;
+    
+    return 1;
+
+}
+
+
+/**
+ * 
+ * This function takes in two integers i and j representing coordinates of a region in the grid.
+ * It rounds the two coordinates to the region origin and hashes that origin to an index. The hashing is simple, we just number the regions
+ * row by row from left to right, and according to i and j we can calculate that number.
+ * 
+ */
+int HashRegion(int i, int j){
+
+    //Step 1: Get region coordinate
+    //The function should first transform i and j into the region corner coordinate which will be then hashed.
+    //This way all coordinates within the same region will be hashed to the same index.
+
+    double regionSize[2] = PROB_REGION_SIZE;
+
+
+    //We can't just add i and j then hash the sum because (1,0) and (0,1) would then hash to the same index
+
+    //Step 2: Hash the resultant value:
+
+    //This is very simple, we are just numbering the regions on the grid row by row from left to right
+
+    double di = (double)i;
+    double dj = (double)j;
+    double GRDSZ = (double)GRIDSIZE;
+
+    double rows = floor(di / regionSize[0]);
+    double cols = ceil(GRIDSIZE / regionSize[1]);
+    double colIdx = floor(dj / regionSize[1]);
+
+    int regionIndex = (int)(rows * cols + colIdx);
+    return regionIndex;
+}
+
+
+/**
+ * Writes the top left cell of a region (the inverse of HashRegion()) to origin.
+ */
+static void RegionOrigin(int region, int origin[2]){
+
+    int regionSize[2] = PROB_REGION_SIZE;
+    int regionColumns = (GRIDSIZE + regionSize[1] - 1) / regionSize[1];
+
+    origin[0] = (region / regionColumns) * regionSize[0];
+    origin[1] = (region % regionColumns) * regionSize[1];
+}
+
+/**
+ * The most a cell can get from the ships afloat, before hits and priors: every ship crossing it both ways.
+ */
+static int AfloatPlacementBound(Fleet * fleet){
+
+    int bound = 0;
+
+    for (int shipLength = 1; shipLength <= fleet->maxLength; shipLength++)
+    {
+        bound += fleet->afloatByLength[shipLength] * 2 * shipLength;
+    }
+
+    return bound;
+}
+
+/**
+ * A stale region of a lazy board gets one element on its origin keyed by AfloatPlacementBound(), so it is filed in the category its cells
+ * could reach without computing them. RefineRegion() replaces it with the real cells before anything reads it.
+ */
+static void InsertStalePlaceholder(Player * player, int region){
+
+    int origin[2];
+    RegionOrigin(region, origin);
+
+    ProbabilityHeapInsert(player->probabilityNodes, &player->probabilityHeapSet[region], origin[0] * GRIDSIZE + origin[1],
+        ToProbabilityValue(AfloatPlacementBound(&player->fleet)));
+}
+
+/**
+ * Returns the category list a heap belongs in according to its highest probability:
+ *      - High probability (2): highest probability >= HIGHPROB_BASE
+ *      - Average probability (1): highest probability >= AVGPROB_BASE but < HIGHPROB_BASE
+ *      - Low probability (0): anything lower
+ * and -1 for an empty heap, which has nothing left to target and stays out of the categories.
+ */
+static int HeapCategory(ProbabilityHeap * heap){
+
+    if (IsProbabilityHeapEmpty(heap)) return -1;
+
+    if (heap->topProbability >= HIGHPROB_BASE) return 2;
+    if (heap->topProbability >= AVGPROB_BASE) return 1;
+    return 0;
+}
+
+/**
+ * Moves the heap of a region to the category list of its highest probability, or out of the categories once it is empty. Heaps remember
+ * their list node, so this is O(1). A heap that stays in the same category keeps its place in the list. Returns 1 if the heap moved, 0
+ * otherwise.
+ */
+int FileProbabilityHeap(Player * player, int region){
+
+    ProbabilityHeap * heap = &player->probabilityHeapSet[region];
+    int category = HeapCategory(heap);
+
+    if (category == heap->category) return 0;
+
+    if (heap->categoryNode != NULL) removeNode(&player->probabilityHeapCategoryLists[heap->category], heap->categoryNode);
+
+    heap->category = (signed char)category;
+    heap->categoryNode = NULL;
+
+    if (category >= 0){
+        addLast(&player->probabilityHeapCategoryLists[category], heap);
+        heap->categoryNode = player->probabilityHeapCategoryLists[category].tail;
+    }
+
+    return 1;
+}
+
+/**
+ * Inserts every cell that can be hunted (on the hunt lattice and not shot yet) into the heap of its region, then files every heap that
+ * received cells into its category:
+ *      - High probability: Heaps of regions with highest probability >= HIGHPROB_BASE macro are placed here
+ *      - Average probability: Heaps of regions with highest probability >= AVGPROB_BASE macro but < HIGHPROB_BASE are placed here
+ *      - Low probability: Heaps of regions with highest probability >= LOWPROB_BASE macro but < AVGPROB_BASE are placed here
+ *      - Null chance: Heaps of regions with highest probability = 0 are placed here
+ * 
+ * Regions with no lattice cell stay empty and out of the categories, like the regions UpdateHeap() empties. Stale regions of lazy boards
+ * only get a placeholder (see InsertStalePlaceholder()).
+ */
+static void FillProbabilityHeaps(Player * player){
+
+    //We will pass over every cell on the grid and insert it into the right Binomial Heap in the heap hashset using the HashRegion() function.
+    //This way is better than looping over regions using math and stuff because the latter would create problems with the Hash values 
+    //(trust me on this, i hurt my soul debugging that)
+
+    //A band is one row of regions, so every heap is filled by a single thread and gets its cells in the same order as in a serial pass:
+    int regionSize[2] = PROB_REGION_SIZE;
+    int bandCount = (GRIDSIZE + regionSize[0] - 1) / regionSize[0];
+
+    #pragma omp parallel for schedule(static) if (GRIDSIZE * GRIDSIZE >= PROB_PARALLEL_MINCELLS)
+    for (int band = 0; band < bandCount; band++)
+    {
+        for (int i = band * regionSize[0]; i < MIN(GRIDSIZE, (band + 1) * regionSize[0]); i++)
+        {
+            for (int j = 0; j < GRIDSIZE; j++)
+            {
+                int cell[2] = {i, j};
+                if (!IsHuntCell(player, i, j) || CheckHitOrMiss(player->grid, cell) || IsStaleCell(player, i, j)) continue;
+
+                ProbabilityHeapInsert(player->probabilityNodes, &player->probabilityHeapSet[HashRegion(i, j)], i * GRIDSIZE + j, player->probabilityGrid[i][j]);
+            }
+        }
+    }
+
+    if (player->staleRegions != NULL){
+        for (int i = 0; i < PROB_REGION_COUNT; i++)
+        {
+            if (player->staleRegions[i]) InsertStalePlaceholder(player, i);
+        }
+    }
+
+    //The categories keep the order of the regions, so they are filled serially:
+
+    for (int i = 0; i < PROB_REGION_COUNT; i++)
+    {
+        FileProbabilityHeap(player, i);
+    }
+}
+
+/**
+ * Empties every region heap and category list, so FillProbabilityHeaps() can start over. Emptying a heap is O(1), so this is a single pass.
+ */
+static void ClearProbabilityHeaps(Player * player){
+
+    for (int i = 0; i < PROB_REGION_COUNT; i++)
+    {
+        InitializeProbabilityHeap(&player->probabilityHeapSet[i]);
+    }
+
+    for (int i = 0; i < PROB_CATEGORYCOUNT; i++)
+    {
+        while (!is_empty(&player->probabilityHeapCategoryLists[i])) removeFirst(&player->probabilityHeapCategoryLists[i]);
+    }
+}
+
+/**
+ * Returns the stride of the hunt lattice: the length of the smallest ship afloat, or 1 once the fleet is sunk.
+ */
+static int HuntStride(Fleet * fleet){
+
+    for (int shipLength = 1; shipLength <= fleet->maxLength; shipLength++)
+    {
+        if (fleet->afloatByLength[shipLength] > 0) return shipLength;
+    }
+
+    return 1;
+}
+
+/**
+ * Out of the stride lattices, picks the one with the fewest cells left to shoot, which is the least work left to cover every ship. Shots
+ * fired while a larger stride (or none) was used count towards it. Between equal ones, the most probable wins.
+ * 
+ * Every game starts from the same knowledge, so the first pick of a game is almost always a transposition cache hit. Later picks follow a
+ * sunk ship, when the probabilities depend on the order of the shots, so they are not cached.
+ */
+static int PickHuntOffset(Player * player, int stride){
+
+    if (stride <= 1) return 0;
+
+    int cacheable = player->sunkShipCount == 0;
+
+    unsigned long long cached;
+    if (cacheable && ProbeTransposition(player, TT_HUNT_OFFSET, stride, &cached)) return (int)cached;
+
+    int * unresolved = (int*)(alloc_TrackedZeroed(MEM_GRIDS, stride, sizeof(int)));
+    long long * probability = (long long*)(alloc_TrackedZeroed(MEM_GRIDS, stride, sizeof(long long)));
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            int cell[2] = {i, j};
+            if (CheckHitOrMiss(player->grid, cell)) continue;
+
+            unresolved[(i + j) % stride]++;
+            probability[(i + j) % stride] += MAX(0, player->probabilityGrid[i][j]);
+        }
+    }
+
+    int best = 0;
+    for (int offset = 1; offset < stride; offset++)
+    {
+        if (unresolved[offset] < unresolved[best] || (unresolved[offset] == unresolved[best] && probability[offset] > probability[best])) best = offset;
+    }
+
+    FreeTracked(unresolved);
+    FreeTracked(probability);
+
+    if (cacheable) StoreTransposition(player, TT_HUNT_OFFSET, stride, (unsigned long long)best);
+
+    return best;
+}
+
+static void RebuildProbabilityHeaps(Player * player, int stride, int offset){
+
+    player->huntStride = stride;
+    player->huntOffset = offset;
+
+    ClearProbabilityHeaps(player);
+    FillProbabilityHeaps(player);
+}
+
+/**
+ * Allocates the heap hashset with every heap empty, the nodes every heap takes its cells from and the category lists.
+ */
+static void AllocateProbabilityHeaps(Player * player){
+
+    player->probabilityHeapSet = (ProbabilityHeap*)(alloc_Tracked(MEM_HEAPS, sizeof(ProbabilityHeap) * PROB_REGION_COUNT));
+    player->probabilityNodes = (ProbabilityNode*)(alloc_Tracked(MEM_HEAPS, sizeof(ProbabilityNode) * GRIDSIZE * GRIDSIZE));
+
+    for (int i = 0; i < PROB_REGION_COUNT; i++)
+    {
+        InitializeProbabilityHeap(&player->probabilityHeapSet[i]);
+    }
+
+    //Initializing the array of linked lists to categorize the probability heaps:
+    player->probabilityHeapCategoryLists = (D_LinkedList*)(alloc_Tracked(MEM_LISTS, sizeof(D_LinkedList) * PROB_CATEGORYCOUNT));
+    for (int i = 0; i < PROB_CATEGORYCOUNT; i++)
+    {
+        initialize_empty_DList(&player->probabilityHeapCategoryLists[i]);
+    }
+}
+
+/**
+ * This function initializes the binomial heaps stored inside the player struct. For every region of the probability graph, the function creates
+ * a heap that stores the coordinates of a region and orders them according to probability. The heap is a maximum heap, it prioritizes higher probabilities.
+ * Only the cells of the hunt lattice are stored (see Player.h), which for a smallest ship of length L is 1 / L of the grid.
+ * 
+ * Maximum memory is allocated for each category (the total number of regions) not to have to realloc every time.
+ */
+int InitializeProbabilityHeaps(Player * player){
+
+    TRACE_SCOPE("InitializeProbabilityHeaps");
+
+    AllocateProbabilityHeaps(player);
+
+    int stride = HuntStride(&player->fleet);
+
+    player->huntStride = stride;
+    player->huntOffset = PickHuntOffset(player, stride);
+
+    FillProbabilityHeaps(player);
+
+    return 1;
+}
+
+/**
+ * Called when a ship sinks. If it was the last ship of the smallest length, the lattice stride grows to the next smallest length, so a new
+ * lattice is picked and the heaps are rebuilt from the probabilityGrid. Returns 1 if they were, 0 if the lattice did not change.
+ */
+int UpdateHuntLattice(Player * player){
+
+    TRACE_SCOPE("UpdateHuntLattice");
+
+    int stride = HuntStride(&player->fleet);
+    if (stride == player->huntStride) return 0;
+
+    RebuildProbabilityHeaps(player, stride, PickHuntOffset(player, stride));
+
+    return 1;
+}
+
+/**
+ * A ship that was hit but not sunk yet may only have cells left off the lattice. When the bot has no task left for it and the lattice is
+ * exhausted, the heaps are rebuilt with every cell. Returns 1 if they were, 0 if every cell was already kept.
+ */
+int WidenHuntLattice(Player * player){
+
+    if (player->huntStride <= 1) return 0;
+
+    RebuildProbabilityHeaps(player, 1, 0);
+
+    return 1;
+}
+
+/**
+ * Lazy boards: marks every region intersecting the area [row0, row1] x [col0, col1] (bounds included, clamped to the grid) as stale. Its
+ * heap keeps its elements and its category, which after a miss is an upper bound of its real one, until RefineRegion() is called.
+ * Returns 1 if the board is lazy, 0 if the caller must update the area itself.
+ */
+int MarkRegionsStale(Player * player, int row0, int row1, int col0, int col1){
+
+    if (player->staleRegions == NULL) return 0;
+
+    int regionSize[2] = PROB_REGION_SIZE;
+
+    row0 = MAX(0, row0);
+    col0 = MAX(0, col0);
+    row1 = MIN(GRIDSIZE - 1, row1);
+    col1 = MIN(GRIDSIZE - 1, col1);
+
+    for (int i = row0 - (row0 % regionSize[0]); i <= row1; i += regionSize[0])
+    {
+        for (int j = col0 - (col0 % regionSize[1]); j <= col1; j += regionSize[1])
+        {
+            player->staleRegions[HashRegion(i, j)] = 1;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Computes the cells of a stale region and, if the region is in a category, refills its heap with them and moves it to the category of its
+ * real highest probability (possibly out of the categories). A region that had been emptied only gets its cells computed, like UpdateHeap()
+ * leaves emptied regions out. Returns 1 if the region was stale, 0 otherwise (and always on eager boards).
+ */
+int RefineRegion(Player * player, int region){
+
+    if (player->staleRegions == NULL || !player->staleRegions[region]) return 0;
+
+    TRACE_SCOPE("RefineRegion");
+
+    METRIC_COUNT(COUNTER_REGIONS_REFINED);
+
+    player->staleRegions[region] = 0;
+
+    //The heaps don't exist yet when the starting grid is displayed:
+    ProbabilityHeap * heap = (player->probabilityHeapSet != NULL) ? &player->probabilityHeapSet[region] : NULL;
+    int listed = heap != NULL && !IsProbabilityHeapEmpty(heap);
+
+    if (listed) ClearProbabilityHeap(heap);
+
+    int origin[2];
+    RegionOrigin(region, origin);
+    int regionSize[2] = PROB_REGION_SIZE;
+
+    for (int i = origin[0]; i < MIN(GRIDSIZE, origin[0] + regionSize[0]); i++)
+    {
+        for (int j = origin[1]; j < MIN(GRIDSIZE, origin[1] + regionSize[1]); j++)
+        {
+            int cell[2] = {i, j};
+            if (CheckHitOrMiss(player->grid, cell)) continue;
+
+            METRIC_COUNT(COUNTER_CELLS_RECOMPUTED);
+            CalcCutoffProb(player, cell);
+            CalcOverlapProb(player, cell);
+
+            //Cells with no chance left are dropped, like UpdateHeap() does:
+            if (listed && IsHuntCell(player, i, j) && player->probabilityGrid[i][j] > 0){
+                ProbabilityHeapInsert(player->probabilityNodes, heap, i * GRIDSIZE + j, player->probabilityGrid[i][j]);
+            }
+        }
+    }
+
+    if (listed) FileProbabilityHeap(player, region);
+
+    return 1;
+}
+
+/**
+ * Refines every stale region, for the queries that read the whole grid. Nothing to do on eager boards.
+ */
+void RefineProbabilities(Player * player){
+
+    if (player->staleRegions == NULL) return;
+
+    for (int i = 0; i < PROB_REGION_COUNT; i++)
+    {
+        RefineRegion(player, i);
+    }
+}
+
+/**
+ * Frees the probability grid, the region heaps with their nodes and the category lists (the lists only point to the heaps, so only their
+ * nodes are freed).
+ */
+void FreeProbabilityState(Player * player){
+
+    //A shared grid belongs to the template:
+    if (player->probabilityTemplate != NULL){
+        player->probabilityGrid = NULL;
+        ReleaseProbabilityTemplate(player);
+    }
+
+    FreeProbabilityGrid(player->probabilityGrid);
+    player->probabilityGrid = NULL;
+
+    FreeTracked(player->staleRegions);
+    player->staleRegions = NULL;
+
+    FreeTracked(player->probabilityHeapSet);
+    player->probabilityHeapSet = NULL;
+
+    FreeTracked(player->probabilityNodes);
+    player->probabilityNodes = NULL;
+
+    if (player->probabilityHeapCategoryLists != NULL){
+        for (int i = 0; i < PROB_CATEGORYCOUNT; i++)
+        {
+            while (!is_empty(&player->probabilityHeapCategoryLists[i])) removeFirst(&player->probabilityHeapCategoryLists[i]);
+        }
+        FreeTracked(player->probabilityHeapCategoryLists);
+        player->probabilityHeapCategoryLists = NULL;
+    }
+}
+
+#pragma endregion
+
+
+
+#pragma region [PROBABILITY TEMPLATE]
+
+/**
+ * The starting probabilities and heaps only depend on the grid size and the fleet, so they are computed once per configuration, on a
+ * scratch player that only has a blank grid, a fleet and the probability state, and shared read-only. A player sharing the template has
+ * its probabilityGrid pointing into it and no heaps of its own. AcquireProbabilityState() gives it copies the first time a bot targets it:
+ * two memcpy() and filing the heaps, instead of computing every cell and inserting every lattice cell. A player no bot ever targets (a human
+ * in a PvP game) never pays for either, so creating players and the memory they take no longer grow with the starting state.
+ *
+ * Like the opening book, one configuration is kept at a time: a player of another fleet replaces the template, and the old one is freed
+ * once the last player sharing it lets go of it. The current one stays allocated from game to game.
+ *
+ * Players with a placement prior start from their own grid, and so do lazy boards, which compute nothing up front (see CalcProbs.h). So do
+ * players that were shot at before any bot targeted them (by humans, in free-for-all games): the template knows nothing of their shots.
+ *
+ * The template can be built on another thread while the players are being set up (see PrewarmProbabilityTemplate()), so every access to
+ * CurrentTemplate and to the users count is in the ProbabilityTemplate critical section.
+ */
+struct ProbabilityTemplate{
+    Player scratch;
+    int users; //Players sharing it.
+};
+
+static ProbabilityTemplate * CurrentTemplate = NULL;
+
+static int SameFleetCounts(Fleet * fleet1, Fleet * fleet2){
+
+    if (fleet1->maxLength != fleet2->maxLength) return 0;
+
+    for (int length = 1; length <= fleet1->maxLength; length++)
+    {
+        if (fleet1->afloatByLength[length] != fleet2->afloatByLength[length]) return 0;
+    }
+
+    return 1;
+}
+
+static ProbabilityTemplate * alloc_ProbabilityTemplate(Fleet * fleet){
+
+    TRACE_SCOPE("alloc_ProbabilityTemplate");
+
+    ProbabilityTemplate * template = (ProbabilityTemplate*)(alloc_TrackedZeroed(MEM_PLAYERS, 1, sizeof(ProbabilityTemplate)));
+    Player * scratch = &template->scratch;
+
+    //Lengths are indexed by ship ID, entry NOSHIP_ID is unused:
+    InitializeFleet(&scratch->fleet, fleet->length + 1, fleet->shipCount);
+    scratch->knowledgeHash = InitialKnowledgeHash(&scratch->fleet);
+
+    scratch->grid = (char**)(alloc_Tracked(MEM_GRIDS, sizeof(char*) * GRIDSIZE));
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        scratch->grid[i] = (char*)(alloc_Tracked(MEM_GRIDS, sizeof(char) * GRIDSIZE));
+        memset(scratch->grid[i], WATER_C, GRIDSIZE);
+    }
+
+    InitializeProbabilities(scratch);
+    InitializeProbabilityHeaps(scratch);
+
+    return template;
+}
+
+static void FreeProbabilityTemplate(ProbabilityTemplate * template){
+
+    Player * scratch = &template->scratch;
+
+    FreeProbabilityState(scratch);
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        FreeTracked(scratch->grid[i]);
+    }
+    FreeTracked(scratch->grid);
 
+    FreeFleet(&scratch->fleet);
+    FreeTracked(template);
 }
 
-#pragma region [Binomial Heap Specific Functions]
-int compareProbabilities(void * elem1, void * elem2){
+/**
+ * Lets go of the current template, freeing it if no player shares it. Must be called in the critical section.
+ */
+static void DetachCurrentTemplate(){
+
+    if (CurrentTemplate == NULL) return;
 
-    //The void pointer will be an integer pointer representing an array of 3 integers
-    //The integer at index 0 is the key and the indices 1 and 2 represent the coordinates i and j respectively
+    ProbabilityTemplate * template = CurrentTemplate;
+    CurrentTemplate = NULL;
 
-    return ((int*)elem2)[0] - ((int*)elem1)[0];//returns elem2 - elem1 so that it would act as a maxheap
+    if (template->users == 0) FreeProbabilityTemplate(template);
 }
 
 /**
- * Input:
- *      - Prob: the probability at this grid coordinate
- *      - i: the row index
- *      - j: the column index
+ * Returns the template of the fleet's configuration, building it if it is not the current one. Must be called in the critical section.
  */
-int BinHeap_Insert_ProbElement(BinomialHeap * binHeap, int Prob, int row, int col){
+static ProbabilityTemplate * TemplateOfFleet(Fleet * fleet){
 
-    int * element = (int*)(malloc(sizeof(int) * 3));
-    element[0] = Prob;
-    element[1] = row;
-    element[2] = col;
-
-    insert(binHeap, (void*)element);
+    if (CurrentTemplate == NULL || !SameFleetCounts(&CurrentTemplate->scratch.fleet, fleet)){
+        DetachCurrentTemplate();
+        CurrentTemplate = alloc_ProbabilityTemplate(fleet);
+    }
 
-    return 1;
+    return CurrentTemplate;
 }
 
 /**
- * This function returns an pointer which represents an array of three integers (probability, i, j).
+ * Makes the player share the starting probability state of its configuration. Returns 1 if it does, 0 if the player must compute its own.
  */
-int* BinHeap_FindHighestProbabilityCell(BinomialHeap * binHeap){
+static int ShareProbabilityTemplate(Player * player){
 
-    void * topVal = findMin(binHeap);
+    if (!IsUntouched(player) || player->placementPrior != NULL || GRIDSIZE * GRIDSIZE >= PROB_LAZY_MINCELLS) return 0;
 
-    return (int*)(topVal);
+    ProbabilityTemplate * template = NULL;
 
-}
+    #pragma omp critical(ProbabilityTemplate)
+    {
+        template = TemplateOfFleet(&player->fleet);
+        template->users++;
+    }
 
-void InOrderTraversalTree_ProbNode(Node * root){
-    if (root == NULL) return;
+    player->probabilityTemplate = template;
+    player->probabilityGrid = template->scratch.probabilityGrid;
+    player->staleRegions = NULL;
+    player->huntStride = template->scratch.huntStride;
+    player->huntOffset = template->scratch.huntOffset;
 
-    
-    InOrderTraversalTree_INT(root->leftChild);
-    printf("%d, ", ((int*)(root->value))[0]);
-    
-    InOrderTraversalTree_INT(root->rightSibling);
+    return 1;
 }
 
-void InOrderTraversal_ProbNode_Print(BinomialHeap * heap){
-
-    if (heap == NULL) return;
+/**
+ * Stops the player from sharing its template, which it must be doing. Its probabilityGrid is left to the caller.
+ */
+void ReleaseProbabilityTemplate(Player * player){
 
-    Node * curr = heap->head;
+    ProbabilityTemplate * template = player->probabilityTemplate;
 
+    player->probabilityTemplate = NULL;
 
-    InOrderTraversalTree_INT(curr);
-    
-    printf("\n");
+    #pragma omp critical(ProbabilityTemplate)
+    {
+        template->users--;
 
+        if (template != CurrentTemplate && template->users == 0) FreeProbabilityTemplate(template);
+    }
 }
 
-#pragma endregion
-
-
 /**
- * 
- * This function takes in two integers i and j representing coordinates of a region in the grid.
- * It rounds the two coordinates to the region origin and hashes that origin to an index. The hashing is simple, we just number the regions
- * row by row from left to right, and according to i and j we can calculate that number.
- * 
+ * Makes the player's probabilityGrid readable, for the queries that don't update it (like PlaceBotShips()): the player shares the template of
+ * its configuration, or gets a state of its own when it can't. Returns 1 if the grid had to be made, 0 if it was already there.
  */
-int HashRegion(int i, int j){
-
-    //Step 1: Get region coordinate
-    //The function should first transform i and j into the region corner coordinate which will be then hashed.
-    //This way all coordinates within the same region will be hashed to the same index.
+int PrepareProbabilityGrid(Player * player){
 
-    double regionSize[2] = PROB_REGION_SIZE;
+    if (player->probabilityGrid != NULL) return 0;
 
+    if (ShareProbabilityTemplate(player) == 0){
+        InitializeProbabilities(player);
+        InitializeProbabilityHeaps(player);
+    }
 
-    //We can't just add i and j then hash the sum because (1,0) and (0,1) would then hash to the same index
+    return 1;
+}
 
-    //Step 2: Hash the resultant value:
+/**
+ * Gives the player a probability state of its own, to be updated by the attacks. It is called the first time a bot targets the player: a
+ * player sharing the template gets a copy of it, unless it was shot at since. The heaps are filed in region order, so the copy is the same
+ * as a state built from scratch.
+ * Returns 1 if the state had to be made, 0 if the player already had its own.
+ */
+int AcquireProbabilityState(Player * player){
 
-    //This is very simple, we are just numbering the regions on the grid row by row from left to right
+    //The template is a blank board. A player that was shot at while sharing it builds its own state from its grid instead:
+    if (player->probabilityTemplate != NULL && !IsUntouched(player)) FreeProbabilityState(player);
 
-    double di = (double)i;
-    double dj = (double)j;
-    double GRDSZ = (double)GRIDSIZE;
+    int prepared = PrepareProbabilityGrid(player);
 
-    double rows = floor(di / regionSize[0]);
-    double cols = ceil(GRIDSIZE / regionSize[1]);
-    double colIdx = floor(dj / regionSize[1]);
+    ProbabilityTemplate * template = player->probabilityTemplate;
+    if (template == NULL) return prepared;
 
-    int regionIndex = (int)(rows * cols + colIdx);
-    return regionIndex;
-}
+    TRACE_SCOPE("AcquireProbabilityState");
 
+    Player * scratch = &template->scratch;
 
-/**
- * This function initializes the binomial heaps stored inside the player struct. For every region of the probability graph, the function creates
- * a heap that stores the coordinates of a region and orders them according to probability. The heap is a maximum heap, it prioritizes higher probabilities.
- * 
- * Heaps could fall into one of three categories:
- *      - High probability: Heaps of regions with highest probability >= HIGHPROB_BASE macro are placed here
- *      - Average probability: Heaps of regions with highest probability >= AVGPROB_BASE macro but < HIGHPROB_BASE are placed here
- *      - Low probability: Heaps of regions with highest probability >= LOWPROB_BASE macro but < AVGPROB_BASE are placed here
- *      - Null chance: Heaps of regions with highest probability = 0 are placed here
- * 
- * Maximum memory is allocated for each category (the total number of regions) not to have to realloc every time.
- */
-int InitializeProbabilityHeaps(Player * player){
+    player->probabilityGrid = alloc_ProbabilityGrid();
+    memcpy(player->probabilityGrid[0], scratch->probabilityGrid[0], sizeof(ProbabilityValue) * GRIDSIZE * GRIDSIZE);
 
-    //Initializing the binomial heap hashset:
-    player->probabilityHeapSet = (BinomialHeap**)(malloc(sizeof(BinomialHeap*) * PROB_REGION_COUNT));
+    AllocateProbabilityHeaps(player);
+    memcpy(player->probabilityHeapSet, scratch->probabilityHeapSet, sizeof(ProbabilityHeap) * PROB_REGION_COUNT);
+    memcpy(player->probabilityNodes, scratch->probabilityNodes, sizeof(ProbabilityNode) * GRIDSIZE * GRIDSIZE);
 
     for (int i = 0; i < PROB_REGION_COUNT; i++)
     {
-        player->probabilityHeapSet[i] = (BinomialHeap * )(malloc(sizeof(BinomialHeap)));
-        player->probabilityHeapSet[i]->head = NULL;
-        player->probabilityHeapSet[i]->compare = compareProbabilities;
-    }
-    
+        //The copies are not in the player's lists yet:
+        player->probabilityHeapSet[i].category = -1;
+        player->probabilityHeapSet[i].categoryNode = NULL;
 
-    //Initializing the array of linked lists to categorize the probability binomial heaps:
-    player->probabilityHeapCategoryLists = (D_LinkedList*)(malloc(sizeof(D_LinkedList) * PROB_CATEGORYCOUNT));
-    for (int i = 0; i < PROB_CATEGORYCOUNT; i++)
-    {
-        initialize_empty_DList(&player->probabilityHeapCategoryLists[i]);
+        FileProbabilityHeap(player, i);
     }
-    
-
 
-    //We will pass over every cell on the grid and insert it into the right Binomial Heap in the heap hashset using the HashRegion() function.
-    //This way is better than looping over regions using math and stuff because the latter would create problems with the Hash values 
-    //(trust me on this, i hurt my soul debugging that)
-
-    for (int i = 0; i < GRIDSIZE; i++)
-    {
-        for (int j = 0; j < GRIDSIZE; j++)
-        {
-            int hashIndex = HashRegion(i,j);
-            //player->probabilityGrid[i][j] = hashIndex;
-            //printf("el: %d,%d | hash: %d\n",i,j,hashIndex);
-            BinHeap_Insert_ProbElement(player->probabilityHeapSet[hashIndex], player->probabilityGrid[i][j], i, j);
-        }
-        
-    }
+    ReleaseProbabilityTemplate(player);
 
-    DisplayIntGrid(player->probabilityGrid, GRIDSIZE);
-    
-    //Now here, we go over the hashset and we categorize the heaps into the three category arrays:
+    return 1;
+}
 
-    for (int i = 0; i < PROB_REGION_COUNT; i++)
-    {
-        BinomialHeap * targetHeap = player->probabilityHeapSet[i];
+/**
+ * Builds the template of the game's fleet ahead of time, so the first bot to need it does not wait. It may run while players are being
+ * set up on another thread (see SetUpHumanPlayers() in Driver.c).
+ */
+void PrewarmProbabilityTemplate(){
 
-        int highestProb = BinHeap_FindHighestProbabilityCell(targetHeap)[0];
+    if (GRIDSIZE * GRIDSIZE >= PROB_LAZY_MINCELLS) return;
 
-        //InOrderTraversal_ProbNode_Print(&binHeap);
-        //printf("highestProb: %d\n", highestProb);
+    TRACE_SCOPE("PrewarmProbabilityTemplate");
 
-        if (highestProb >= HIGHPROB_BASE){
+    Fleet fleet;
+    InitializeFleet(&fleet, GameShipLengths, GameShipCount);
 
-            //Place in list of index 2 for high probabilities:
-            addLast(&player->probabilityHeapCategoryLists[2], targetHeap);
-        }
-        else if (highestProb >= AVGPROB_BASE){
-            //Place in array of index 1 for avg probabilities:
-            addLast(&player->probabilityHeapCategoryLists[1], targetHeap);
-        }
-        else {
-            //Place in array of index 0 for low probabilities:
-            addLast(&player->probabilityHeapCategoryLists[0], targetHeap);
-        }
-        
+    #pragma omp critical(ProbabilityTemplate)
+    {
+        TemplateOfFleet(&fleet);
     }
-    
-
-//    DisplayIntGrid(player->probabilityGrid, GRIDSIZE);
-            
-//    InOrderTraversal_ProbNode_Print(&binHeap);
 
+    FreeFleet(&fleet);
+}
 
-    //exit(0);
-    
+/**
+ * Lets go of the current template: it is freed now if no player shares it, or by the last one that does. The next player builds a new one.
+ */
+void CloseProbabilityTemplate(){
 
-    return 1;
+    #pragma omp critical(ProbabilityTemplate)
+    {
+        DetachCurrentTemplate();
+    }
 }
 
 #pragma endregion
@@ -329,14 +970,13 @@ int InitializeProbabilityHeaps(Player * player){
 
 #pragma region [Bot-Specific Initializations]
 
+/**
+ * Every hit queues at most 4 tasks, so a queue of 4 tasks per cell of the game's fleet holds every task against one opponent. In
+ * free-for-all games, where tasks against several opponents can be pending at once, the queue may still grow. Humans get an empty queue.
+ */
 int InitializeBotStackMemory(Player * bot){
 
-    //To be continued...
-    if (bot->isBot == true)
-        bot->stackMemory = create_empty_Dlist();
-    else bot->stackMemory = NULL;
-
-    return 1;
+    return InitializeTaskQueue(&bot->stackMemory, bot->isBot ? 4 * bot->fleet.unhitCells : 0);
 }
 
 #pragma endregion
@@ -373,7 +1013,7 @@ void DisplayGrid(char ** grid, int gridSize){
     {
         char* num = alloc_IntegerToNumeral(i, gridSize, startingCoordinate_1, endingCoordinate_1);
         printf("%s ", num);
-        free(num);
+        FreeTracked(num);
     }
 
     Println("");
@@ -384,7 +1024,7 @@ void DisplayGrid(char ** grid, int gridSize){
         
         Indent(h/2 - 7 - strlen(num) - 1);
         printf("%s%*s", num, 8, "");
-        free(num);
+        FreeTracked(num);
 
         for (int j = 0; j < gridSize; j++)
         {
@@ -406,7 +1046,19 @@ void DisplayGrid(char ** grid, int gridSize){
 
 }
 
-void DisplayIntGrid(int ** grid, int gridSize){
+/**
+ * Displays what attackers know of the player's grid. A display reads every cell, so a lazy board is refined first.
+ */
+void DisplayProbabilityGrid(Player * player){
+
+    PrepareProbabilityGrid(player);
+    RefineProbabilities(player);
+    DisplayIntGrid(player->probabilityGrid, GRIDSIZE);
+}
+
+void DisplayIntGrid(ProbabilityValue ** grid, int gridSize){
+
+    TRACE_SCOPE("DisplayIntGrid");
 
     //I need to calculate proper indentation between grid squares. It depends on the length of the numerals:
     int base = endingCoordinate_1 - startingCoordinate_1 + 1;
@@ -428,7 +1080,7 @@ void DisplayIntGrid(int ** grid, int gridSize){
     {
         char* num = alloc_IntegerToNumeral(i, gridSize, startingCoordinate_1, endingCoordinate_1);
         printf("%s ", num);
-        free(num);
+        FreeTracked(num);
     }
 
     Println("");
@@ -439,7 +1091,7 @@ void DisplayIntGrid(int ** grid, int gridSize){
         
         Indent(h/2 - 7 - strlen(num) - 1);
         printf("%s%*s", num, 8, "");
-        free(num);
+        FreeTracked(num);
 
         for (int j = 0; j < gridSize; j++)
         {
@@ -463,7 +1115,7 @@ void DisplayIntGrid(int ** grid, int gridSize){
 
 int IsShipChar(char c){
 
-    return (c == BATTLESHIP_C || c == SUBMARINE_C || c == DESTROYER_C || c == CARRIER_C);
+    return IsShip(c);
 
 }
 
@@ -472,6 +1124,8 @@ int IsShipChar(char c){
  */
 void DisplayOpponentGrid(char ** grid, int gridSize, int showMiss){
 
+    TRACE_SCOPE("DisplayOpponentGrid");
+
     //I need to calculate proper indentation between grid squares. It depends on the length of the numerals:
     int base = endingCoordinate_1 - startingCoordinate_1 + 1;
     int TopNumLen = 0;
@@ -490,7 +1144,7 @@ void DisplayOpponentGrid(char ** grid, int gridSize, int showMiss){
     {
         char* num = alloc_IntegerToNumeral(i, gridSize, startingCoordinate_1, endingCoordinate_1);
         printf("%s ", num);
-        free(num);
+        FreeTracked(num);
     }
 
     Println("");
@@ -500,7 +1154,7 @@ void DisplayOpponentGrid(char ** grid, int gridSize, int showMiss){
         char* num = alloc_IntegerToNumeral(i, gridSize, startingCoordinate_2, endingCoordinate_2);
         Indent(h/2 - 7 - strlen(num) - 1);
         printf("%s%*s", num, 8, "");
-        free(num);
+        FreeTracked(num);
 
         for (int j = 0; j < gridSize; j++)
         {
@@ -546,41 +1200,311 @@ void DisplayOpponentGrid(char ** grid, int gridSize, int showMiss){
 
 
 
-//I hate this function, for some reason I debugged it for 2 hrs
-int countSunkShips(Player* player){
+#pragma region [FLEET]
+
+/**
+ * Sets the fleet of the games that will be created next. Must be called before the players are initialized.
+ * Returns 1 if the fleet was accepted and -1 if it has too many ships or a ship that can't fit on the grid.
+ */
+int SetGameFleet(const int * shipLengths, int shipCount){
+
+    if (shipCount <= 0 || shipCount > MAXSHIPCOUNT) return -1;
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        if (shipLengths[i] <= 0 || shipLengths[i] > GRIDSIZE) return -1;
+    }
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        GameShipLengths[i] = shipLengths[i];
+    }
+    GameShipCount = shipCount;
+
+    return 1;
+}
+
+/**
+ * Allocates the fleet's arrays for shipCount ships of the given lengths (ship i gets ID i + 1). Positions are set when the ships are placed.
+ */
+int InitializeFleet(Fleet * fleet, const int * shipLengths, int shipCount){
+
+    fleet->shipCount = shipCount;
+    fleet->maxLength = 0;
+    fleet->unhitCells = 0;
 
-    int res = MAX(0, checkIfSunk(player, &(player->battleshipBounds)));
-    res += MAX(0, checkIfSunk(player, &(player->carrierBounds)));
-    res += MAX(0, checkIfSunk(player, &(player->destroyerBounds)));
-    res += MAX(0, checkIfSunk(player, &(player->submarineBounds)));
+    for (int i = 0; i < shipCount; i++)
+    {
+        fleet->maxLength = MAX(fleet->maxLength, shipLengths[i]);
+    }
 
-    return MAX(0,res);
+    fleet->startRow = (int*)(alloc_TrackedZeroed(MEM_PLAYERS, shipCount + 1, sizeof(int)));
+    fleet->endRow = (int*)(alloc_TrackedZeroed(MEM_PLAYERS, shipCount + 1, sizeof(int)));
+    fleet->startCol = (int*)(alloc_TrackedZeroed(MEM_PLAYERS, shipCount + 1, sizeof(int)));
+    fleet->endCol = (int*)(alloc_TrackedZeroed(MEM_PLAYERS, shipCount + 1, sizeof(int)));
+    fleet->length = (int*)(alloc_TrackedZeroed(MEM_PLAYERS, shipCount + 1, sizeof(int)));
+    fleet->hits = (int*)(alloc_TrackedZeroed(MEM_PLAYERS, shipCount + 1, sizeof(int)));
+    fleet->sunk = (bool*)(alloc_TrackedZeroed(MEM_PLAYERS, shipCount + 1, sizeof(bool)));
+    fleet->afloatByLength = (int*)(alloc_TrackedZeroed(MEM_PLAYERS, fleet->maxLength + 1, sizeof(int)));
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        fleet->length[i + 1] = shipLengths[i];
+        fleet->afloatByLength[shipLengths[i]]++;
+        fleet->unhitCells += shipLengths[i];
+    }
 
+    return 1;
 }
 
-int checkIfSunk(Player *player, ShipBounds *shipBounds) {
+void FreeFleet(Fleet * fleet){
 
-    for (int i = shipBounds->startRow; i <= shipBounds->endRow; i++) {
-        for (int j = shipBounds->startCol; j <= shipBounds->endCol; j++) {
-            if (player->grid[i][j] != HIT) {
-                shipBounds->IsSunk=0;
-                return -1;
-            }
+    FreeTracked(fleet->startRow);
+    FreeTracked(fleet->endRow);
+    FreeTracked(fleet->startCol);
+    FreeTracked(fleet->endCol);
+    FreeTracked(fleet->length);
+    FreeTracked(fleet->hits);
+    FreeTracked(fleet->sunk);
+    FreeTracked(fleet->afloatByLength);
+
+    fleet->shipCount = 0;
+    fleet->maxLength = 0;
+}
+
+/**
+ * Returns 1 if shipID is the ID of one of the player's ships, 0 otherwise (NOSHIP_ID included).
+ */
+int IsShipID(Player * player, int shipID){
+
+    return shipID > NOSHIP_ID && shipID <= player->fleet.shipCount;
+}
+
+/**
+ * Ships are drawn with the char of the classic ship of the same length, or SHIP_C if there is none.
+ */
+char ShipCharFromLength(int length){
+
+    switch (length)
+    {
+    case CARRIER_LENGTH:
+        return CARRIER_C;
+    case BATTLESHIP_LENGTH:
+        return BATTLESHIP_C;
+    case DESTROYER_LENGTH:
+        return DESTROYER_C;
+    case SUBMARINE_LENGTH:
+        return SUBMARINE_C;
+    default:
+        return SHIP_C;
+    }
+}
+
+char * ShipTypeName(int length){
+
+    switch (length)
+    {
+    case CARRIER_LENGTH:
+        return "Carrier";
+    case BATTLESHIP_LENGTH:
+        return "Battleship";
+    case DESTROYER_LENGTH:
+        return "Destroyer";
+    case SUBMARINE_LENGTH:
+        return "Submarine";
+    default:
+        return "Ship";
+    }
+}
+
+#pragma endregion
+
+/**
+ * This function must be called by every attack that turns a ship cell into a HIT. It increments the hit counter of the ship that was hit and,
+ * if that was its last standing cell, marks it as sunk and increments the player's sunk ship count.
+ * 
+ * Input:
+ *      - player: the player whose ship was hit
+ *      - shipID: the ID stored in the player's shipIdGrid at the cell that was hit
+ * 
+ * Output:
+ *      - 1 if the hit sunk the ship, 0 if it didn't and -1 if shipID is not a ship.
+ */
+int RegisterShipHit(Player * player, int shipID){
+
+    if (!IsShipID(player, shipID)) return -1;
+
+    Fleet * fleet = &player->fleet;
+
+    fleet->hits[shipID]++;
+    fleet->unhitCells--;
+
+    if (fleet->sunk[shipID] || fleet->hits[shipID] < fleet->length[shipID]) return 0;
+
+    int length = fleet->length[shipID];
+
+    player->knowledgeHash ^= ZobristFleetKey(length, fleet->afloatByLength[length]);
+    if (fleet->afloatByLength[length] > 1) player->knowledgeHash ^= ZobristFleetKey(length, fleet->afloatByLength[length] - 1);
+
+    fleet->sunk[shipID] = true;
+    fleet->afloatByLength[length]--;
+    player->sunkShipCount++;
+
+    return 1;
+}
+
+#pragma region [AREA QUERIES]
+
+/**
+ * Allocates the player's radar summed-area table. The grid is still empty at this point so every entry starts at 0.
+ */
+int InitializeRadarAreaTable(Player * player){
+
+    player->radarAreaTable = (int**)(alloc_Tracked(MEM_GRIDS, sizeof(int*) * (GRIDSIZE + 1)));
+
+    for (int i = 0; i <= GRIDSIZE; i++)
+    {
+        player->radarAreaTable[i] = (int*)(alloc_TrackedZeroed(MEM_GRIDS, GRIDSIZE + 1, sizeof(int)));
+    }
+
+    return 1;
+}
+
+/**
+ * Must be called after the cells starting at (row0, col0) changed (a ship was placed or smoke was applied). Only the entries that sum
+ * over a changed cell are recomputed, which are the ones below and to the right of it. They are visited in row order, so the recurrence
+ * only ever reads entries that are either unchanged or already recomputed.
+ */
+int UpdateRadarAreaTable(Player * player, int row0, int col0){
+
+    if (!IndexWithinRange(row0) || !IndexWithinRange(col0)) return -1;
+
+    int ** table = player->radarAreaTable;
+
+    for (int i = row0; i < GRIDSIZE; i++)
+    {
+        for (int j = col0; j < GRIDSIZE; j++)
+        {
+            char c = player->grid[i][j];
+            int detectable = !player->smokeGrid[i][j] && (IsShip(c) || c == HIT);
+
+            table[i + 1][j + 1] = detectable + table[i][j + 1] + table[i + 1][j] - table[i][j];
         }
     }
-    shipBounds->IsSunk=1;
+
     return 1;
 }
 
+/**
+ * Returns the number of unsmoked ship cells within the rectangle [row0, row1] x [col0, col1] (bounds included) in O(1).
+ * The rectangle is clipped to the grid.
+ */
+int QueryRadarArea(Player * player, int row0, int row1, int col0, int col1){
+
+    row0 = MAX(0, row0);
+    col0 = MAX(0, col0);
+    row1 = MIN(GRIDSIZE - 1, row1);
+    col1 = MIN(GRIDSIZE - 1, col1);
+
+    if (row0 > row1 || col0 > col1) return 0;
+
+    int ** table = player->radarAreaTable;
+
+    return table[row1 + 1][col1 + 1] - table[row0][col1 + 1] - table[row1 + 1][col0] + table[row0][col0];
+}
+
+#pragma endregion
+
+/**
+ * Returns the number of ships the player lost. The count is kept up to date by RegisterShipHit() so there is no need to rescan the grid.
+ */
+int countSunkShips(Player* player){
+
+    return player->sunkShipCount;
+
+}
+
+/**
+ * Returns 1 while the player still has a ship afloat, 0 once the whole fleet was sunk (the player is out of the game).
+ */
+int IsPlayerAlive(Player* player){
+
+    return player->sunkShipCount < player->fleet.shipCount;
+}
+
+/**
+ * Records a miss of the attacker on a cell of the target that the grid does not show (hard difficulty). Misses already recorded are
+ * ignored, so the count stays the number of distinct cells.
+ */
+void RecordHiddenMiss(Player * attacker, Player * target, int row, int col){
+
+    int slot = -1;
+
+    for (int i = 0; i < MAXOPPONENTCOUNT && slot < 0; i++)
+    {
+        if (attacker->hiddenMissTargets[i] == target) slot = i;
+    }
+
+    for (int i = 0; i < MAXOPPONENTCOUNT && slot < 0; i++)
+    {
+        if (attacker->hiddenMissTargets[i] != NULL) continue;
+
+        attacker->hiddenMisses[i] = (unsigned char*)(alloc_TrackedZeroed(MEM_PLAYERS, (GRIDSIZE * GRIDSIZE + 7) / 8, sizeof(unsigned char)));
+        if (attacker->hiddenMisses[i] == NULL) return;
+
+        attacker->hiddenMissTargets[i] = target;
+        slot = i;
+    }
+
+    if (slot < 0) return;
+
+    int index = row * GRIDSIZE + col;
+    unsigned char bit = (unsigned char)(1 << (index & 7));
+
+    if (attacker->hiddenMisses[slot][index >> 3] & bit) return;
+
+    attacker->hiddenMisses[slot][index >> 3] |= bit;
+    attacker->hiddenMissCount[slot]++;
+}
+
+/**
+ * Returns the chance that a shot of the attacker on one of the target's cells it knows nothing about is a hit: the ship cells not hit yet
+ * over the cells the attacker knows nothing about. Those are the cells the grid shows (hits, and misses unless they are hidden) and the
+ * hidden misses of the attacker itself. Every count is maintained incrementally so this is O(1) per target.
+ */
+double ExpectedHitChance(Player * attacker, Player * target){
+
+    int known = target->resolvedCells;
+
+    for (int i = 0; i < MAXOPPONENTCOUNT; i++)
+    {
+        if (attacker->hiddenMissTargets[i] == target) known += attacker->hiddenMissCount[i];
+    }
+
+    int unresolved = GRIDSIZE * GRIDSIZE - known;
+
+    if (unresolved <= 0) return 0;
+
+    return (double)target->fleet.unhitCells / unresolved;
+}
+
+/**
+ * Returns 1 if the ship is sunk and -1 otherwise (or if shipID is not a ship). This is a single lookup in the fleet.
+ */
+int checkIfSunk(Player *player, int shipID) {
+
+    return (IsShipID(player, shipID) && player->fleet.sunk[shipID]) ? 1 : -1;
+}
+
 
 void ShowPlayerStats(Player * player){
     Println("");
     char * txt = CreateString_alloc(2, player->name, "'s STATS:");
     Println_Centered(txt, strlen(txt), player->UIColor);
 
-    free(txt);
+    FreeTracked(txt);
 
-    int shipsLeft = 4 - player->currSunkShips;
+    int shipsLeft = player->fleet.shipCount - player->currSunkShips;
 
     Print_Centered("Ships left: ", strlen("Ships left: 1"), player->UIColor);
     
@@ -601,7 +1525,7 @@ void Show_2_PlayerStats(Player * player, Player * opponent){
     ShowPlayerStats(player);
     Print_Centered("Torpedo: ", strlen("Torpedo: 1"), player->UIColor);
     SetColor(player->UIColor);
-    printf("%d", (player->prevSunk && opponent->currSunkShips >= 3)?(1):0);
+    printf("%d", CanUseWeapon(WEAPON_TORPEDO, player, opponent));
     ResetFormat();
     Println("");
 
@@ -0,0 +1,92 @@
+#include "../include/ProbabilityHeap.h"
+#include "../include/Metrics.h"
+
+/**
+ * Makes the heap empty and unfiled.
+ */
+void InitializeProbabilityHeap(ProbabilityHeap * heap){
+
+    ClearProbabilityHeap(heap);
+
+    heap->category = -1;
+    heap->categoryNode = NULL;
+}
+
+/**
+ * Empties the heap in O(1). Its category is left to the caller.
+ */
+void ClearProbabilityHeap(ProbabilityHeap * heap){
+
+    heap->head = NOCELL;
+    heap->top = NOCELL;
+    heap->topProbability = 0;
+}
+
+/**
+ * Links two roots of the same degree, the one with the lower probability becoming the first child of the other. Returns the new root.
+ */
+static int LinkCells(ProbabilityNode * nodes, int root1, int root2){
+
+    if (nodes[root2].probability > nodes[root1].probability){
+        int temp = root1;
+        root1 = root2;
+        root2 = temp;
+    }
+
+    nodes[root2].rightSibling = nodes[root1].leftChild;
+    nodes[root1].leftChild = root2;
+    nodes[root1].degree++;
+
+    return root1;
+}
+
+/**
+ * Inserts the cell, whose node must not be in any heap. Like insert() of BinomialHeap.c, the new tree is put in front of the roots and
+ * linked with them as long as degrees match, so this runs in O(logn).
+ */
+void ProbabilityHeapInsert(ProbabilityNode * nodes, ProbabilityHeap * heap, int cell, ProbabilityValue probability){
+
+    METRIC_COUNT(COUNTER_HEAP_INSERTS);
+
+    nodes[cell].leftChild = NOCELL;
+    nodes[cell].rightSibling = heap->head;
+    nodes[cell].probability = probability;
+    nodes[cell].degree = 0;
+
+    int root = cell;
+
+    while (nodes[root].rightSibling != NOCELL && nodes[nodes[root].rightSibling].degree == nodes[root].degree)
+    {
+        int next = nodes[nodes[root].rightSibling].rightSibling;
+
+        root = LinkCells(nodes, root, nodes[root].rightSibling);
+        nodes[root].rightSibling = next;
+    }
+
+    heap->head = root;
+
+    if (heap->top == NOCELL || probability > heap->topProbability){
+        heap->top = cell;
+        heap->topProbability = probability;
+    }
+}
+
+static int CollectCells(const ProbabilityNode * nodes, int node, int * cells, int count){
+
+    while (node != NOCELL)
+    {
+        cells[count++] = node;
+        count = CollectCells(nodes, nodes[node].leftChild, cells, count);
+        node = nodes[node].rightSibling;
+    }
+
+    return count;
+}
+
+/**
+ * Writes every cell of the heap to cells, which must be able to hold all of them, and returns how many there are.
+ */
+int ProbabilityHeapCells(const ProbabilityNode * nodes, const ProbabilityHeap * heap, int * cells){
+
+    return CollectCells(nodes, heap->head, cells, 0);
+}
@@ -0,0 +1,545 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/Profiles.h"
+#include "../include/Player.h"
+#include "../include/Memory.h"
+#include "../include/MappedFile.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define MakeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define MakeDirectory(path) mkdir(path, 0755)
+#endif
+
+#define PROFILE_MAGIC "BSPF"
+
+/**
+ * A record is this header followed by lengthCount + 1 heatmaps of GRIDSIZE * GRIDSIZE floats. heat[s][cell] is the decayed number of games
+ * in which the player covered the cell with a ship of length length[s], and lengthGames[s] the decayed number of games that had such a ship.
+ * The last heatmap holds the decayed number of early shots the player fired at each cell, out of shotGames games. earlyShots, parityShots
+ * and edgeShots count the same shots by kind.
+ * Every field is 4 bytes wide, so the heatmaps of every record in the file stay aligned.
+ */
+typedef struct ProfileRecord{
+    char magic[4];
+    int version;
+    int recordSize;
+    int gridSize;
+    char name[PROFILE_NAMELENGTH];
+    float games;
+    int lengthCount;
+    int length[PROFILE_LENGTHSLOTS];
+    float lengthGames[PROFILE_LENGTHSLOTS];
+    float shotGames;
+    float earlyShots;
+    float parityShots[2]; //On cells where row + col is even, and odd.
+    float edgeShots;
+} ProfileRecord;
+
+/**
+ * Placements of a finished game, waiting to be appended by FlushProfiles().
+ */
+typedef struct PendingProfile{
+    char name[PROFILE_NAMELENGTH];
+    int shipCount;
+    int (*bounds)[4];
+    int * length;
+    int * earlyShots;
+    int earlyShotCount;
+} PendingProfile;
+
+static const void * StoreMapping = NULL;
+static size_t StoreSize = 0;
+static int StoreMapped = 0; //Set once the store was looked for, even if it does not exist yet.
+
+static PendingProfile * PendingProfiles = NULL;
+static int PendingCount = 0;
+
+#pragma region [STORE]
+
+static const char * ProfileDirectory(){
+
+    const char * directory = getenv("BATTLESHIP_PROFILE_DIR");
+    return (directory != NULL) ? directory : "profiles";
+}
+
+static char * alloc_StorePath(const char * suffix){
+
+    const char * directory = ProfileDirectory();
+
+    char * path = (char*)(alloc_Tracked(MEM_STRINGS, strlen(directory) + strlen(suffix) + 64));
+    sprintf(path, "%s/profiles_%d.store%s", directory, GRIDSIZE, suffix);
+
+    return path;
+}
+
+static size_t RecordSize(int lengthCount){
+
+    return sizeof(ProfileRecord) + sizeof(float) * (size_t)(lengthCount + 1) * GRIDSIZE * GRIDSIZE;
+}
+
+void CloseProfileStore(){
+
+    UnmapReadOnlyFile(StoreMapping, StoreSize);
+
+    StoreMapping = NULL;
+    StoreSize = 0;
+    StoreMapped = 0;
+}
+
+static void MapProfileStore(){
+
+    if (StoreMapped) return;
+
+    char * path = alloc_StorePath("");
+    StoreMapping = MapReadOnlyFile(path, &StoreSize);
+    FreeTracked(path);
+
+    StoreMapped = 1;
+}
+
+/**
+ * Returns the record at offset, or NULL at the end of the log. A record cut short by an interrupted append ends the log there.
+ */
+static const ProfileRecord * RecordAt(size_t offset){
+
+    if (StoreMapping == NULL || offset + sizeof(ProfileRecord) > StoreSize) return NULL;
+
+    const ProfileRecord * record = (const ProfileRecord*)((const char*)(StoreMapping) + offset);
+
+    if (memcmp(record->magic, PROFILE_MAGIC, 4) != 0 || record->version != PROFILE_VERSION || record->gridSize != GRIDSIZE) return NULL;
+    if (record->lengthCount < 0 || record->lengthCount > PROFILE_LENGTHSLOTS) return NULL;
+    if ((size_t)record->recordSize != RecordSize(record->lengthCount) || offset + record->recordSize > StoreSize) return NULL;
+
+    return record;
+}
+
+/**
+ * Returns the current (last) record of the name in the mapped store, or NULL if the player was never recorded.
+ */
+static const ProfileRecord * FindProfile(const char * name){
+
+    const ProfileRecord * found = NULL;
+
+    size_t offset = 0;
+    for (const ProfileRecord * record = RecordAt(offset); record != NULL; record = RecordAt(offset))
+    {
+        if (strncmp(record->name, name, PROFILE_NAMELENGTH - 1) == 0) found = record;
+        offset += record->recordSize;
+    }
+
+    return found;
+}
+
+static const float * RecordHeat(const ProfileRecord * record, int slot){
+
+    return (const float*)(record + 1) + (size_t)slot * GRIDSIZE * GRIDSIZE;
+}
+
+static const float * RecordShotHeat(const ProfileRecord * record){
+
+    return RecordHeat(record, record->lengthCount);
+}
+
+/**
+ * Size of the log up to its first unreadable record (an interrupted append, or records of an older PROFILE_VERSION).
+ */
+static size_t ReadableSize(){
+
+    size_t offset = 0;
+    for (const ProfileRecord * record = RecordAt(offset); record != NULL; record = RecordAt(offset)) offset += record->recordSize;
+
+    return offset;
+}
+
+#pragma endregion
+
+#pragma region [PRIOR]
+
+/**
+ * Returns the prior of a player that was recorded before, for the lengths of their current fleet, or NULL for a new player. The heatmaps
+ * are not copied.
+ */
+PlacementPrior * alloc_PlacementPrior(Player * player){
+
+    MapProfileStore();
+
+    const ProfileRecord * record = FindProfile(player->name);
+    if (record == NULL) return NULL;
+
+    PlacementPrior * prior = (PlacementPrior*)(alloc_Tracked(MEM_PLAYERS, sizeof(PlacementPrior)));
+    prior->count = 0;
+
+    for (int s = 0; s < record->lengthCount; s++)
+    {
+        int length = record->length[s];
+
+        if (length > player->fleet.maxLength || player->fleet.afloatByLength[length] == 0 || record->lengthGames[s] <= 0.0f) continue;
+
+        prior->length[prior->count] = length;
+        prior->scale[prior->count] = (float)PROFILE_PRIOR_PERCENT / 100.0f * 2.0f * (float)length / record->lengthGames[s];
+        prior->heat[prior->count] = RecordHeat(record, s);
+        prior->count++;
+    }
+
+    if (prior->count == 0){
+        FreeTracked(prior);
+        return NULL;
+    }
+
+    return prior;
+}
+
+#pragma endregion
+
+#pragma region [SHOTS]
+
+static int IsEdgeCell(int row, int col){
+
+    return MIN(MIN(row, col), MIN(GRIDSIZE - 1 - row, GRIDSIZE - 1 - col)) < PROFILE_EDGEBAND;
+}
+
+/**
+ * Called for every shot of a human player. Only the first PROFILE_EARLYSHOTS are kept: they are the ones showing how the player searches.
+ */
+void RecordEarlyShot(Player * player, int row, int col){
+
+    if (player == NULL || player->earlyShots == NULL || player->earlyShotCount >= PROFILE_EARLYSHOTS) return;
+    if (row < 0 || row >= GRIDSIZE || col < 0 || col >= GRIDSIZE) return;
+
+    player->earlyShots[player->earlyShotCount++] = row * GRIDSIZE + col;
+}
+
+/**
+ * Adds weight times the chance that the player fires at each cell within their first PROFILE_EARLYSHOTS shots to density. The chance is the
+ * share of recorded games in which they did, blended with what their parity and edge shares predict for cells of the same kind:
+ * 
+ *      coverage = (heat[cell] + PROFILE_SHOTPRIOR_GAMES * predicted[kind]) / (shotGames + PROFILE_SHOTPRIOR_GAMES)
+ * 
+ * Returns 1, or 0 without touching density if the player has no recorded shots.
+ */
+int AddEarlyCoverage(Player * player, int ** density, int weight){
+
+    if (player == NULL || player->isBot) return 0;
+
+    MapProfileStore();
+
+    const ProfileRecord * record = FindProfile(player->name);
+    if (record == NULL || record->shotGames <= 0.0f || record->earlyShots <= 0.0f) return 0;
+
+    //Number of cells of each kind, [parity][edge]:
+    int cells[2][2] = {{0, 0}, {0, 0}};
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++) cells[(i + j) % 2][IsEdgeCell(i, j)]++;
+    }
+
+    //Expected early shots per game on one cell of each kind, taking parity and edges as independent:
+    float shotsPerGame = record->earlyShots / record->shotGames;
+    float edgeShare = record->edgeShots / record->earlyShots;
+    float predicted[2][2];
+
+    for (int parity = 0; parity < 2; parity++)
+    {
+        float parityShare = record->parityShots[parity] / record->earlyShots;
+
+        for (int edge = 0; edge < 2; edge++)
+        {
+            float share = parityShare * (edge ? edgeShare : 1.0f - edgeShare);
+            predicted[parity][edge] = (cells[parity][edge] > 0) ? MIN(1.0f, shotsPerGame * share / cells[parity][edge]) : 0.0f;
+        }
+    }
+
+    const float * heat = RecordShotHeat(record);
+    float games = record->shotGames + PROFILE_SHOTPRIOR_GAMES;
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            float coverage = (heat[i * GRIDSIZE + j] + PROFILE_SHOTPRIOR_GAMES * predicted[(i + j) % 2][IsEdgeCell(i, j)]) / games;
+            density[i][j] += (int)(weight * MIN(1.0f, coverage) + 0.5f);
+        }
+    }
+
+    return 1;
+}
+
+#pragma endregion
+
+#pragma region [RECORDING]
+
+/**
+ * Keeps the placements of a human player's fleet and their early shots until FlushProfiles(). Bots are not recorded.
+ */
+void QueueProfile(Player * player){
+
+    if (player == NULL || player->isBot) return;
+
+    Fleet * fleet = &player->fleet;
+
+    PendingProfile * grown = (PendingProfile*)(alloc_Tracked(MEM_PLAYERS, sizeof(PendingProfile) * (PendingCount + 1)));
+    if (PendingCount > 0) memcpy(grown, PendingProfiles, sizeof(PendingProfile) * PendingCount);
+    FreeTracked(PendingProfiles);
+    PendingProfiles = grown;
+
+    PendingProfile * pending = &PendingProfiles[PendingCount++];
+
+    strncpy(pending->name, player->name, PROFILE_NAMELENGTH - 1);
+    pending->name[PROFILE_NAMELENGTH - 1] = '\0';
+
+    pending->shipCount = fleet->shipCount;
+    pending->bounds = (int (*)[4])(alloc_Tracked(MEM_PLAYERS, sizeof(int[4]) * fleet->shipCount));
+    pending->length = (int*)(alloc_Tracked(MEM_PLAYERS, sizeof(int) * fleet->shipCount));
+
+    for (int i = 0; i < fleet->shipCount; i++)
+    {
+        int shipID = i + 1;
+        pending->bounds[i][0] = fleet->startRow[shipID];
+        pending->bounds[i][1] = fleet->endRow[shipID];
+        pending->bounds[i][2] = fleet->startCol[shipID];
+        pending->bounds[i][3] = fleet->endCol[shipID];
+        pending->length[i] = fleet->length[shipID];
+    }
+
+    pending->earlyShotCount = player->earlyShotCount;
+    pending->earlyShots = (int*)(alloc_Tracked(MEM_PLAYERS, sizeof(int) * (player->earlyShotCount + 1)));
+    if (player->earlyShotCount > 0) memcpy(pending->earlyShots, player->earlyShots, sizeof(int) * player->earlyShotCount);
+}
+
+/**
+ * Builds the next version of a record: the previous one decayed, plus the game. base is NULL for a new player.
+ */
+static ProfileRecord * alloc_NextRecord(const ProfileRecord * base, PendingProfile * pending){
+
+    int length[PROFILE_LENGTHSLOTS];
+    int lengthCount = 0;
+
+    if (base != NULL){
+        for (int s = 0; s < base->lengthCount; s++) length[lengthCount++] = base->length[s];
+    }
+
+    for (int i = 0; i < pending->shipCount; i++)
+    {
+        int known = 0;
+        for (int s = 0; s < lengthCount && !known; s++) known = (length[s] == pending->length[i]);
+
+        if (!known && lengthCount < PROFILE_LENGTHSLOTS) length[lengthCount++] = pending->length[i];
+    }
+
+    ProfileRecord * record = (ProfileRecord*)(alloc_TrackedZeroed(MEM_GRIDS, 1, RecordSize(lengthCount)));
+
+    memcpy(record->magic, PROFILE_MAGIC, 4);
+    record->version = PROFILE_VERSION;
+    record->recordSize = (int)RecordSize(lengthCount);
+    record->gridSize = GRIDSIZE;
+    memcpy(record->name, pending->name, PROFILE_NAMELENGTH);
+    record->games = ((base != NULL) ? base->games * PROFILE_DECAY : 0.0f) + 1.0f;
+    record->lengthCount = lengthCount;
+
+    float * heat = (float*)(record + 1);
+
+    for (int s = 0; s < lengthCount; s++)
+    {
+        record->length[s] = length[s];
+
+        if (base != NULL && s < base->lengthCount){
+            record->lengthGames[s] = base->lengthGames[s] * PROFILE_DECAY;
+
+            const float * baseHeat = RecordHeat(base, s);
+            for (int cell = 0; cell < GRIDSIZE * GRIDSIZE; cell++)
+            {
+                heat[(size_t)s * GRIDSIZE * GRIDSIZE + cell] = baseHeat[cell] * PROFILE_DECAY;
+            }
+        }
+
+        int seen = 0;
+        for (int i = 0; i < pending->shipCount; i++)
+        {
+            if (pending->length[i] != length[s]) continue;
+            seen = 1;
+
+            int * bounds = pending->bounds[i];
+            for (int r = bounds[0]; r <= bounds[1]; r++)
+            {
+                for (int c = bounds[2]; c <= bounds[3]; c++)
+                {
+                    heat[(size_t)s * GRIDSIZE * GRIDSIZE + r * GRIDSIZE + c] += 1.0f;
+                }
+            }
+        }
+
+        if (seen) record->lengthGames[s] += 1.0f;
+    }
+
+    float * shotHeat = heat + (size_t)lengthCount * GRIDSIZE * GRIDSIZE;
+
+    if (base != NULL){
+        record->shotGames = base->shotGames * PROFILE_DECAY;
+        record->earlyShots = base->earlyShots * PROFILE_DECAY;
+        record->parityShots[0] = base->parityShots[0] * PROFILE_DECAY;
+        record->parityShots[1] = base->parityShots[1] * PROFILE_DECAY;
+        record->edgeShots = base->edgeShots * PROFILE_DECAY;
+
+        const float * baseShotHeat = RecordShotHeat(base);
+        for (int cell = 0; cell < GRIDSIZE * GRIDSIZE; cell++)
+        {
+            shotHeat[cell] = baseShotHeat[cell] * PROFILE_DECAY;
+        }
+    }
+
+    if (pending->earlyShotCount > 0) record->shotGames += 1.0f;
+
+    for (int k = 0; k < pending->earlyShotCount; k++)
+    {
+        int row = pending->earlyShots[k] / GRIDSIZE;
+        int col = pending->earlyShots[k] % GRIDSIZE;
+
+        shotHeat[pending->earlyShots[k]] += 1.0f;
+        record->earlyShots += 1.0f;
+        record->parityShots[(row + col) % 2] += 1.0f;
+        if (IsEdgeCell(row, col)) record->edgeShots += 1.0f;
+    }
+
+    return record;
+}
+
+/**
+ * Rewrites the store with the current record of every player, in a temporary file renamed over the store. This also drops an unreadable end
+ * of the log, which would otherwise hide every record appended after it. If the store can't be replaced (another process has it open on
+ * Windows), the log is simply left as it is.
+ */
+static void CompactProfileStore(){
+
+    MapProfileStore();
+
+    size_t totalSize = 0;
+    size_t liveSize = 0;
+    int recordCount = 0;
+
+    for (const ProfileRecord * record = RecordAt(0); record != NULL; record = RecordAt(totalSize))
+    {
+        totalSize += record->recordSize;
+        recordCount++;
+    }
+
+    const ProfileRecord ** live = (const ProfileRecord**)(alloc_Tracked(MEM_PLAYERS, sizeof(ProfileRecord*) * (recordCount + 1)));
+    int liveCount = 0;
+
+    size_t offset = 0;
+    for (const ProfileRecord * record = RecordAt(offset); record != NULL; record = RecordAt(offset))
+    {
+        offset += record->recordSize;
+
+        if (FindProfile(record->name) != record) continue;
+
+        live[liveCount++] = record;
+        liveSize += record->recordSize;
+    }
+
+    if (totalSize == StoreSize && totalSize <= liveSize * PROFILE_COMPACT_RATIO){
+        FreeTracked(live);
+        return;
+    }
+
+    char * path = alloc_StorePath("");
+    char * tempPath = alloc_StorePath(".tmp");
+
+    FILE * out = fopen(tempPath, "wb");
+    int written = (out != NULL);
+
+    for (int i = 0; i < liveCount && written; i++)
+    {
+        written = fwrite(live[i], live[i]->recordSize, 1, out) == 1;
+    }
+
+    if (out != NULL && fclose(out) != 0) written = 0;
+
+    FreeTracked(live);
+
+    //Nothing may point into the old file once it is replaced:
+    CloseProfileStore();
+
+    if (written) remove(path);
+    if (!written || rename(tempPath, path) != 0) remove(tempPath);
+
+    FreeTracked(path);
+    FreeTracked(tempPath);
+}
+
+/**
+ * Appends the queued profiles to the store in a single write, then compacts it if needed. Returns the number of records written, or -1 if
+ * the store could not be written. The store is unmapped, so no player may hold a prior anymore.
+ */
+int FlushProfiles(){
+
+    if (PendingCount == 0) return 0;
+
+    MapProfileStore();
+
+    ProfileRecord ** records = (ProfileRecord**)(alloc_Tracked(MEM_PLAYERS, sizeof(ProfileRecord*) * PendingCount));
+    size_t batchSize = 0;
+
+    for (int p = 0; p < PendingCount; p++)
+    {
+        //A name queued twice builds on its version from this batch:
+        const ProfileRecord * base = NULL;
+        for (int q = 0; q < p; q++)
+        {
+            if (strcmp(records[q]->name, PendingProfiles[p].name) == 0) base = records[q];
+        }
+        if (base == NULL) base = FindProfile(PendingProfiles[p].name);
+
+        records[p] = alloc_NextRecord(base, &PendingProfiles[p]);
+        batchSize += records[p]->recordSize;
+    }
+
+    char * batch = (char*)(alloc_Tracked(MEM_GRIDS, batchSize));
+    size_t offset = 0;
+
+    for (int p = 0; p < PendingCount; p++)
+    {
+        memcpy(batch + offset, records[p], records[p]->recordSize);
+        offset += records[p]->recordSize;
+
+        FreeTracked(records[p]);
+        FreeTracked(PendingProfiles[p].bounds);
+        FreeTracked(PendingProfiles[p].length);
+        FreeTracked(PendingProfiles[p].earlyShots);
+    }
+
+    int flushed = PendingCount;
+
+    FreeTracked(records);
+    FreeTracked(PendingProfiles);
+    PendingProfiles = NULL;
+    PendingCount = 0;
+
+    //Records appended after an unreadable end of the log would never be found:
+    if (ReadableSize() < StoreSize) CompactProfileStore();
+
+    CloseProfileStore();
+
+    MakeDirectory(ProfileDirectory());
+
+    char * path = alloc_StorePath("");
+    FILE * out = fopen(path, "ab");
+    int written = out != NULL && fwrite(batch, batchSize, 1, out) == 1;
+
+    if (out != NULL && fclose(out) != 0) written = 0;
+
+    FreeTracked(path);
+    FreeTracked(batch);
+
+    if (!written) return -1;
+
+    CompactProfileStore();
+    CloseProfileStore();
+
+    return flushed;
+}
+
+#pragma endregion
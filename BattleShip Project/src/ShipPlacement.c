@@ -1,27 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "../include/ShipPlacement.h"
+#include "../include/Memory.h"
 
 
 /**
- * This function is used to setup the bounds of the passed in Shipbound struct. Shipbound structs are stored in the Player struct
- * and used to store ship area location.
+ * This function is used to setup the bounds of a ship in the player's fleet, which stores the ship area locations.
  */
-void setShipBounds(int startRow, int endRow, int startCol, int endCol, ShipBounds *shipBounds) {
-    shipBounds->startRow = startRow;
-    shipBounds->startCol = startCol;
-    shipBounds->endRow = endRow;
-    shipBounds->endCol = endCol;
-    shipBounds->IsSunk = false;
+void setShipBounds(int startRow, int endRow, int startCol, int endCol, Fleet *fleet, int shipID) {
+    fleet->startRow[shipID] = startRow;
+    fleet->startCol[shipID] = startCol;
+    fleet->endRow[shipID] = endRow;
+    fleet->endCol[shipID] = endCol;
+    fleet->hits[shipID] = 0;
+    fleet->sunk[shipID] = false;
 }
 
 /**
  * Places the player's ship on the grid by filling the necessary elements in the grid 2D array. This function places ships with a default horizontal orientation.
  * It calls the PlaceShipOnGridHelper function. For more details check the documentation of the last function.
  */
-int PlaceShipOnGridHorizontal(Player *player,char shipChar, char **grid, char coords[], int ship_size[2], char ** outputMsg){
+int PlaceShipOnGridHorizontal(Player *player, int shipID, char **grid, char coords[], int ship_size[2], char ** outputMsg){
     char orientation[] = "horizontal";
-    return PlaceShipOnGridHelper(player,shipChar, grid, coords, orientation, ship_size, outputMsg);
+    return PlaceShipOnGridHelper(player, shipID, grid, coords, orientation, ship_size, outputMsg);
 }
 
 /**
@@ -30,9 +32,9 @@ int PlaceShipOnGridHorizontal(Player *player,char shipChar, char **grid, char co
  * It calculates the i and j array bounds within which the elements of the 2D array must be modified to store the ship character. Then it
  * calls the ModifyGridArea function which modifies those elements.
  * 
- * It also initializes the stored Shipbounds of each ship inside the player struct.
+ * It also initializes the bounds of the ship of ID shipID in the player's fleet.
  */
-int PlaceShipOnGridHelper(Player *player, char shipChar, char **grid, char coords[], char orientation[], int ship_size[2] , char ** outputMsg) {
+int PlaceShipOnGridHelper(Player *player, int shipID, char **grid, char coords[], char orientation[], int ship_size[2] , char ** outputMsg) {
 
     int *arrayCoords = alloc_ArrayCoordsFromUserCoords(coords, outputMsg);
     if (arrayCoords == NULL) {
@@ -41,51 +43,58 @@ int PlaceShipOnGridHelper(Player *player, char shipChar, char **grid, char coord
 
     int *shipbounds = alloc_GridAreaFromInput(coords, orientation, ship_size[0] - 1, ship_size[1], outputMsg);
     if (shipbounds == NULL) {
-        free(arrayCoords);
+        FreeTracked(arrayCoords);
+        return -1;
+    }
+
+    int placement = PlaceShipAtBounds(player, shipID, grid, shipbounds, outputMsg);
+
+    FreeTracked(arrayCoords);
+    FreeTracked(shipbounds);
+
+    return placement;
+}
+
+/**
+ * Places a ship directly from array bounds [row0, row1, col0, col1] (bounds included), without going through user coordinates.
+ * It checks the bounds and overlaps, writes the ship char and ship ID on the grid, updates the radar table and sets the ship's bounds in the fleet.
+ * 
+ * Returns 1 if the ship was placed and -1 otherwise (with the reason stored in outputMsg).
+ */
+int PlaceShipAtBounds(Player *player, int shipID, char **grid, int shipbounds[4], char ** outputMsg) {
+
+    if (!IsShipID(player, shipID)) {
+        if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, "Unknown ship type.");
         return -1;
     }
 
     if (!IndexWithinRange(shipbounds[0]) || !IndexWithinRange(shipbounds[1])
      || !IndexWithinRange(shipbounds[2]) || !IndexWithinRange(shipbounds[3])) {
         if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, "Ship bounds out of range. Please pick an area inside the grid.");
-        free(arrayCoords);
-        free(shipbounds);
         return -1;
     }
 
     if (CheckForOverlap(grid, shipbounds) == true) {
         if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, "Cannot place ship! A ship already exists in the designated area.");
-        free(arrayCoords);
-        free(shipbounds);
         return -1;
     }
 
     // Place ship on the grid
-    ModifyGridArea(grid, GRIDSIZE, shipbounds, shipChar);
-
-    // Set bounds for the specific ship in the player structure
-    switch (shipChar) {
-        case CARRIER_C: // Carrier
-            setShipBounds(shipbounds[0], shipbounds[1], shipbounds[2], shipbounds[3], &(player->carrierBounds));
-            break;
-        case BATTLESHIP_C: // Battleship
-            setShipBounds(shipbounds[0], shipbounds[1], shipbounds[2], shipbounds[3], &(player->battleshipBounds));
-            break;
-        case DESTROYER_C: // Destroyer
-            setShipBounds(shipbounds[0], shipbounds[1], shipbounds[2], shipbounds[3], &(player->destroyerBounds));
-            break;
-        case SUBMARINE_C: // Submarine
-            setShipBounds(shipbounds[0], shipbounds[1], shipbounds[2], shipbounds[3], &(player->submarineBounds));
-            break;
-        default:
-            if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, "Unknown ship type.");
-            free(arrayCoords);
-            free(shipbounds);
-            return -1;
-    }
-
-    free(arrayCoords);
-    free(shipbounds);
+    ModifyGridArea(grid, GRIDSIZE, shipbounds, ShipCharFromLength(player->fleet.length[shipID]));
+
+    // Record which ship owns every cell of the area so hits can be attributed after the char is overwritten
+    for (int i = shipbounds[0]; i <= shipbounds[1]; i++)
+    {
+        for (int j = shipbounds[2]; j <= shipbounds[3]; j++)
+        {
+            player->shipIdGrid[i][j] = (unsigned char)shipID;
+        }
+    }
+
+    UpdateRadarAreaTable(player, shipbounds[0], shipbounds[2]);
+
+    // Set bounds for the specific ship in the player's fleet
+    setShipBounds(shipbounds[0], shipbounds[1], shipbounds[2], shipbounds[3], &player->fleet, shipID);
 
     return 1;
 }
@@ -127,3 +136,498 @@ int CheckForOverlap(char **grid, int bounds[]) {
     return false;  
 }
 
+
+
+#pragma region [RANDOM FLEET GENERATION]
+
+/**
+ * Rather than picking random coordinates and retrying on overlap, the generator enumerates every anchor (top left cell) where a ship of a
+ * given length fits, in both orientations, and draws one of them uniformly. An anchor on a line is valid when the ship's cells starting at it
+ * are all free, which is computed for a whole line at once on its occupancy bits:
+ * 
+ *      anchors = free & (free >> 1) & ... & (free >> (length - 1))
+ * 
+ * Lines without any occupied cell are never computed, they hold exactly GRIDSIZE - length + 1 anchors, so the draw only visits the occupied
+ * lines. Every draw succeeds on the first try and costs O(occupied lines * GRIDSIZE / 64), independently of the grid's area.
+ */
+
+void InitializeOccupancyBoard(OccupancyBoard * board){
+    memset(board, 0, sizeof(OccupancyBoard));
+}
+
+/**
+ * Empties the board by only clearing the lines that were used, which is much cheaper than a full memset when generating fleets in batches.
+ */
+void ClearOccupancyBoard(OccupancyBoard * board){
+
+    for (int k = 0; k < board->usedRowCount; k++)
+    {
+        memset(board->rows[board->usedRows[k]], 0, sizeof(board->rows[0]));
+        board->rowUsed[board->usedRows[k]] = false;
+    }
+    for (int k = 0; k < board->usedColCount; k++)
+    {
+        memset(board->cols[board->usedCols[k]], 0, sizeof(board->cols[0]));
+        board->colUsed[board->usedCols[k]] = false;
+    }
+
+    board->usedRowCount = 0;
+    board->usedColCount = 0;
+}
+
+/**
+ * Adds a line to a sorted list of used lines.
+ */
+static void AddUsedLine(int * usedLines, int * usedCount, int line){
+
+    int k = *usedCount;
+
+    while (k > 0 && usedLines[k - 1] > line)
+    {
+        usedLines[k] = usedLines[k - 1];
+        k--;
+    }
+
+    usedLines[k] = line;
+    (*usedCount)++;
+}
+
+/**
+ * Marks the cells within bounds [row0, row1, col0, col1] (bounds included) as occupied.
+ */
+void MarkOccupied(OccupancyBoard * board, int bounds[4]){
+
+    for (int i = bounds[0]; i <= bounds[1]; i++)
+    {
+        for (int j = bounds[2]; j <= bounds[3]; j++)
+        {
+            board->rows[i][j / 64] |= 1ULL << (j % 64);
+            board->cols[j][i / 64] |= 1ULL << (i % 64);
+
+            if (!board->rowUsed[i]){
+                board->rowUsed[i] = true;
+                AddUsedLine(board->usedRows, &board->usedRowCount, i);
+            }
+            if (!board->colUsed[j]){
+                board->colUsed[j] = true;
+                AddUsedLine(board->usedCols, &board->usedColCount, j);
+            }
+        }
+    }
+}
+
+/**
+ * xorshift64* generator. rand() only guarantees 15 bits on some platforms, which is less than the number of anchors on large grids.
+ */
+unsigned long long NextPlacementRandom(unsigned long long * state){
+
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Computes the anchor bitmask of one occupied line and returns how many anchors it has.
+ */
+static int LineAnchors(const unsigned long long * occupied, int shipLength, unsigned long long * anchors){
+
+    int count = 0;
+
+    for (int w = 0; w < OCCUPANCY_WORDS; w++)
+    {
+        unsigned long long mask = ~0ULL;
+
+        for (int k = 0; k < shipLength; k++)
+        {
+            //Bits of word w shifted right by k, pulling in the low bits of the next word:
+            int word = w + (k / 64);
+            int shift = k % 64;
+
+            unsigned long long shifted = (word < OCCUPANCY_WORDS) ? (occupied[word] >> shift) : ~0ULL;
+            if (shift != 0) shifted |= (word + 1 < OCCUPANCY_WORDS) ? (occupied[word + 1] << (64 - shift)) : (~0ULL << (64 - shift));
+
+            mask &= ~shifted;
+        }
+
+        //Anchors past GRIDSIZE - shipLength would run off the grid:
+        int lastAnchor = GRIDSIZE - shipLength;
+        int firstBit = w * 64;
+
+        if (lastAnchor < firstBit) mask = 0;
+        else if (lastAnchor - firstBit < 63) mask &= (1ULL << (lastAnchor - firstBit + 1)) - 1;
+
+        anchors[w] = mask;
+        count += __builtin_popcountll(mask);
+    }
+
+    return count;
+}
+
+/**
+ * Returns the position of the n-th (0 based) set bit of a line mask.
+ */
+static int SelectAnchor(const unsigned long long * anchors, int n){
+
+    for (int w = 0; w < OCCUPANCY_WORDS; w++)
+    {
+        int bits = __builtin_popcountll(anchors[w]);
+
+        if (n < bits){
+            unsigned long long mask = anchors[w];
+            for (int k = 0; k < n; k++)
+            {
+                mask &= mask - 1;
+            }
+            return w * 64 + __builtin_ctzll(mask);
+        }
+
+        n -= bits;
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the k-th (0 based) line that is not in the sorted list of used lines.
+ */
+static int KthFreeLine(const int * usedLines, int usedCount, int k){
+
+    int line = k;
+
+    for (int u = 0; u < usedCount && usedLines[u] <= line; u++)
+    {
+        line++;
+    }
+
+    return line;
+}
+
+/**
+ * Returns the total number of valid placements (horizontal and vertical) of a ship of the given length.
+ */
+int CountShipAnchors(OccupancyBoard * board, int shipLength){
+
+    if (shipLength <= 0 || shipLength > GRIDSIZE) return 0;
+
+    unsigned long long anchors[OCCUPANCY_WORDS];
+    int freeLines = (GRIDSIZE - board->usedRowCount) + (GRIDSIZE - board->usedColCount);
+    int total = freeLines * (GRIDSIZE - shipLength + 1);
+
+    for (int k = 0; k < board->usedRowCount; k++)
+    {
+        total += LineAnchors(board->rows[board->usedRows[k]], shipLength, anchors);
+    }
+    for (int k = 0; k < board->usedColCount; k++)
+    {
+        total += LineAnchors(board->cols[board->usedCols[k]], shipLength, anchors);
+    }
+
+    return total;
+}
+
+/**
+ * Draws one of the valid placements of a ship uniformly at random, marks it on the board and stores it in bounds as [row0, row1, col0, col1].
+ * Returns 1 on success and 0 if the ship fits nowhere.
+ * 
+ * The placements are numbered as: the anchors of the used rows, then those of the used columns, then those of the free rows and finally
+ * those of the free columns. A single random number in [0, total) then picks the placement.
+ */
+int PickRandomShipPlacement(OccupancyBoard * board, int shipLength, unsigned long long * rngState, int bounds[4]){
+
+    if (shipLength <= 0 || shipLength > GRIDSIZE) return 0;
+
+    unsigned long long anchors[OCCUPANCY_WORDS];
+    int usedCounts[2 * GRIDSIZE];
+    int usedLines = board->usedRowCount + board->usedColCount;
+    int usedTotal = 0;
+
+    for (int k = 0; k < usedLines; k++)
+    {
+        const unsigned long long * bits = (k < board->usedRowCount) ? board->rows[board->usedRows[k]] : board->cols[board->usedCols[k - board->usedRowCount]];
+        usedCounts[k] = LineAnchors(bits, shipLength, anchors);
+        usedTotal += usedCounts[k];
+    }
+
+    int freeLine = GRIDSIZE - shipLength + 1;
+    int freeRows = GRIDSIZE - board->usedRowCount;
+    int freeCols = GRIDSIZE - board->usedColCount;
+    int total = usedTotal + (freeRows + freeCols) * freeLine;
+
+    if (total == 0) return 0;
+
+    int n = (int)(((NextPlacementRandom(rngState) >> 32) * (unsigned long long)total) >> 32);
+
+    bool vertical;
+    int index;
+    int anchor;
+
+    if (n < usedTotal){
+
+        int k = 0;
+        while (n >= usedCounts[k])
+        {
+            n -= usedCounts[k];
+            k++;
+        }
+
+        vertical = k >= board->usedRowCount;
+        index = (vertical) ? board->usedCols[k - board->usedRowCount] : board->usedRows[k];
+
+        LineAnchors((vertical) ? board->cols[index] : board->rows[index], shipLength, anchors);
+        anchor = SelectAnchor(anchors, n);
+    }
+    else {
+
+        n -= usedTotal;
+
+        int line = n / freeLine;
+        anchor = n % freeLine;
+
+        vertical = line >= freeRows;
+        index = (vertical) ? KthFreeLine(board->usedCols, board->usedColCount, line - freeRows) : KthFreeLine(board->usedRows, board->usedRowCount, line);
+    }
+
+    if (vertical){
+        bounds[0] = anchor;
+        bounds[1] = anchor + shipLength - 1;
+        bounds[2] = index;
+        bounds[3] = index;
+    }
+    else {
+        bounds[0] = index;
+        bounds[1] = index;
+        bounds[2] = anchor;
+        bounds[3] = anchor + shipLength - 1;
+    }
+
+    MarkOccupied(board, bounds);
+
+    return 1;
+}
+
+/**
+ * Places a whole fleet on the board, one ship after the other, storing the bounds of ship i in outBounds[i].
+ * Returns 1 on success and 0 if some ship could not fit.
+ */
+int GenerateRandomFleet(OccupancyBoard * board, const int * shipLengths, int shipCount, unsigned long long * rngState, int (*outBounds)[4]){
+
+    for (int i = 0; i < shipCount; i++)
+    {
+        if (!PickRandomShipPlacement(board, shipLengths[i], rngState, outBounds[i])) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Batch mode for simulations and test corpora: generates fleetCount independent random fleets on an empty grid. The bounds of ship s of
+ * fleet f are stored in outBounds[f * shipCount + s]. A single board is reused and only its used lines are cleared between fleets.
+ * Returns the number of fleets generated.
+ */
+int GenerateRandomFleets(int fleetCount, const int * shipLengths, int shipCount, unsigned long long seed, int (*outBounds)[4]){
+
+    OccupancyBoard * board = (OccupancyBoard*)(alloc_Tracked(MEM_GRIDS, sizeof(OccupancyBoard)));
+    InitializeOccupancyBoard(board);
+
+    unsigned long long rngState = (seed != 0) ? seed : 0x9E3779B97F4A7C15ULL;
+
+    int generated = 0;
+
+    for (int f = 0; f < fleetCount; f++)
+    {
+        if (!GenerateRandomFleet(board, shipLengths, shipCount, &rngState, &outBounds[f * shipCount])) break;
+
+        ClearOccupancyBoard(board);
+        generated++;
+    }
+
+    FreeTracked(board);
+
+    return generated;
+}
+
+#pragma endregion
+
+
+
+#pragma region [LOW DENSITY PLACEMENT]
+
+/**
+ * A uniformly random fleet is exactly what a probability driven opponent expects. The low density placement instead draws many random
+ * candidate fleets and keeps the one lying on the lowest targeting density, where the density is any per-cell grid: the probability model
+ * the bot itself uses for targeting (CalcProbs.c) or a heatmap of where an opponent usually shoots.
+ * 
+ * The density is turned into a summed-area table once, so the score of a ship is a single rectangle query. Candidates are scored
+ * incrementally while their ships are added and abandoned as soon as their partial score is already worse than the best fleet found,
+ * and candidates are evaluated in parallel when the build enables OpenMP.
+ */
+
+/**
+ * Builds the summed-area table of a GRIDSIZE x GRIDSIZE density grid. Like the radar table, it has GRIDSIZE + 1 rows and columns and
+ * table[i][j] holds the sum of the rectangle [0, i) x [0, j). Negative densities (the probability grid can dip below 0 around misses)
+ * count as 0, which keeps partial scores monotonic.
+ */
+int ** alloc_DensityAreaTable(int ** density){
+
+    int ** table = (int**)(alloc_Tracked(MEM_GRIDS, sizeof(int*) * (GRIDSIZE + 1)));
+
+    for (int i = 0; i <= GRIDSIZE; i++)
+    {
+        table[i] = (int*)(alloc_TrackedZeroed(MEM_GRIDS, GRIDSIZE + 1, sizeof(int)));
+    }
+
+    for (int i = 0; i < GRIDSIZE; i++)
+    {
+        for (int j = 0; j < GRIDSIZE; j++)
+        {
+            table[i + 1][j + 1] = MAX(0, density[i][j]) + table[i][j + 1] + table[i + 1][j] - table[i][j];
+        }
+    }
+
+    return table;
+}
+
+void FreeDensityAreaTable(int ** table){
+
+    if (table == NULL) return;
+
+    for (int i = 0; i <= GRIDSIZE; i++)
+    {
+        FreeTracked(table[i]);
+    }
+
+    FreeTracked(table);
+}
+
+/**
+ * Returns the total density under a ship with bounds [row0, row1, col0, col1] (bounds included) in O(1).
+ */
+int ShipDensityScore(int ** densityTable, int bounds[4]){
+
+    return densityTable[bounds[1] + 1][bounds[3] + 1] - densityTable[bounds[0]][bounds[3] + 1]
+         - densityTable[bounds[1] + 1][bounds[2]] + densityTable[bounds[0]][bounds[2]];
+}
+
+/**
+ * Takes the first placed ships of a candidate off a board that was a copy of base, which leaves it equal to base again. Candidate ships
+ * never overlap the ships of base or each other, so their cells are cleared, and the lines only they used are dropped from the used lists.
+ * This costs O(ship cells + used lines) where copying base again would cost the whole board.
+ */
+static void RemoveCandidateShips(OccupancyBoard * board, const OccupancyBoard * base, int (*bounds)[4], int placed){
+
+    for (int s = 0; s < placed; s++)
+    {
+        for (int i = bounds[s][0]; i <= bounds[s][1]; i++)
+        {
+            for (int j = bounds[s][2]; j <= bounds[s][3]; j++)
+            {
+                board->rows[i][j / 64] &= ~(1ULL << (j % 64));
+                board->cols[j][i / 64] &= ~(1ULL << (i % 64));
+                board->rowUsed[i] = base->rowUsed[i];
+                board->colUsed[j] = base->colUsed[j];
+            }
+        }
+    }
+
+    //The used lists stay sorted, keeping the lines of base leaves exactly the lists of base:
+    int kept = 0;
+    for (int k = 0; k < board->usedRowCount; k++)
+    {
+        if (base->rowUsed[board->usedRows[k]]) board->usedRows[kept++] = board->usedRows[k];
+    }
+    board->usedRowCount = kept;
+
+    kept = 0;
+    for (int k = 0; k < board->usedColCount; k++)
+    {
+        if (base->colUsed[board->usedCols[k]]) board->usedCols[kept++] = board->usedCols[k];
+    }
+    board->usedColCount = kept;
+}
+
+/**
+ * Draws candidateCount random fleets on top of the ships already marked on base and stores the one with the lowest total density in
+ * outBounds (ship i in outBounds[i]). base is left untouched.
+ * 
+ * Candidate k always uses the same random stream (derived from seed and k) and ties are broken by the lowest k, so the result does not
+ * depend on how many threads evaluated the candidates.
+ * 
+ * Returns the score of the chosen fleet, or -1 if no candidate could fit the whole fleet.
+ */
+long long PickLowDensityFleet(OccupancyBoard * base, int ** densityTable, const int * shipLengths, int shipCount, int candidateCount, unsigned long long seed, int (*outBounds)[4]){
+
+    long long bestScore = -1;
+    int bestCandidate = -1;
+
+    #pragma omp parallel
+    {
+        //Each thread copies base once, and takes every candidate off its copy afterwards (see RemoveCandidateShips()):
+        OccupancyBoard * board = (OccupancyBoard*)(alloc_Tracked(MEM_GRIDS, sizeof(OccupancyBoard)));
+        memcpy(board, base, sizeof(OccupancyBoard));
+
+        int (*bounds)[4] = (int (*)[4])(alloc_Tracked(MEM_GRIDS, sizeof(int[4]) * shipCount));
+        int (*localBest)[4] = (int (*)[4])(alloc_Tracked(MEM_GRIDS, sizeof(int[4]) * shipCount));
+
+        long long localScore = -1;
+        int localCandidate = -1;
+
+        #pragma omp for schedule(dynamic, 64)
+        for (int k = 0; k < candidateCount; k++)
+        {
+            unsigned long long rngState = seed ^ ((unsigned long long)(k + 1) * 0x9E3779B97F4A7C15ULL);
+            if (rngState == 0) rngState = 1;
+
+            long long score = 0;
+            bool complete = true;
+            int placed = 0;
+
+            for (int s = 0; s < shipCount; s++)
+            {
+                if (!PickRandomShipPlacement(board, shipLengths[s], &rngState, bounds[s])){
+                    complete = false;
+                    break;
+                }
+
+                placed++;
+                score += ShipDensityScore(densityTable, bounds[s]);
+
+                //The remaining ships can only add to the score:
+                if (localScore >= 0 && score > localScore){
+                    complete = false;
+                    break;
+                }
+            }
+
+            RemoveCandidateShips(board, base, bounds, placed);
+
+            if (!complete) continue;
+
+            if (localScore < 0 || score < localScore || (score == localScore && k < localCandidate)){
+                localScore = score;
+                localCandidate = k;
+                memcpy(localBest, bounds, sizeof(int[4]) * shipCount);
+            }
+        }
+
+        #pragma omp critical
+        {
+            if (localCandidate >= 0 && (bestScore < 0 || localScore < bestScore || (localScore == bestScore && localCandidate < bestCandidate))){
+                bestScore = localScore;
+                bestCandidate = localCandidate;
+                memcpy(outBounds, localBest, sizeof(int[4]) * shipCount);
+            }
+        }
+
+        FreeTracked(board);
+        FreeTracked(bounds);
+        FreeTracked(localBest);
+    }
+
+    return bestScore;
+}
+
+#pragma endregion
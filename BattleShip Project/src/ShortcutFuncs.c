@@ -1,4 +1,5 @@
 #include "../include/ShortcutFuncs.h"
+#include "../include/Memory.h"
 
 
 void Print(char* str){
@@ -43,7 +44,7 @@ char * CreateString_alloc(int strCount, ...){
     }
     len++;
 
-    res = (char*)(malloc(sizeof(char) * len));
+    res = (char*)(alloc_Tracked(MEM_STRINGS, sizeof(char) * len));
 
     va_end(args);
     va_start(args, strCount);
@@ -84,7 +85,7 @@ char * ConcatCharArrays_alloc(int strCount, ...){
     }
     //len++;
 
-    res = (char*)(malloc(sizeof(char) * len));
+    res = (char*)(alloc_Tracked(MEM_STRINGS, sizeof(char) * len));
 
     va_end(args);
     va_start(args, strCount);
@@ -0,0 +1,188 @@
+#include "../include/Trace.h"
+
+#ifdef ENABLE_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include "../include/Metrics.h"
+
+/**
+ * Every thread appends its finished spans to its own TraceBuffer, a list of fixed size chunks, so recording never waits on another
+ * thread and never copies old events. Buffers are pushed onto TraceBuffers with a compare-and-swap the first time a thread records,
+ * and are only read back when the trace is written at exit.
+ */
+#define TRACE_CHUNK_EVENTS 4096
+
+typedef struct TraceEvent{
+    const char * name;
+    unsigned long long start;
+    unsigned long long duration;
+} TraceEvent;
+
+typedef struct TraceChunk{
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+    int count;
+    struct TraceChunk * next;
+} TraceChunk;
+
+typedef struct TraceBuffer{
+    int threadId;
+    TraceChunk * first;
+    TraceChunk * last;
+    struct TraceBuffer * next;
+} TraceBuffer;
+
+static _Atomic(TraceBuffer *) TraceBuffers = NULL;
+static atomic_int NextTraceThreadId = 0;
+static _Thread_local TraceBuffer * LocalTraceBuffer = NULL;
+
+static unsigned long long TraceStart = 0;
+
+static void (*PreviousIntHandler)(int) = SIG_DFL;
+static void (*PreviousTermHandler)(int) = SIG_DFL;
+
+#pragma region [RECORDING]
+
+static TraceChunk * alloc_TraceChunk(){
+
+    TraceChunk * chunk = (TraceChunk*)(malloc(sizeof(TraceChunk)));
+    chunk->count = 0;
+    chunk->next = NULL;
+
+    return chunk;
+}
+
+static TraceBuffer * GetLocalTraceBuffer(){
+
+    if (LocalTraceBuffer != NULL) return LocalTraceBuffer;
+
+    TraceBuffer * buffer = (TraceBuffer*)(malloc(sizeof(TraceBuffer)));
+    buffer->threadId = atomic_fetch_add(&NextTraceThreadId, 1);
+    buffer->first = alloc_TraceChunk();
+    buffer->last = buffer->first;
+
+    buffer->next = atomic_load(&TraceBuffers);
+    while (!atomic_compare_exchange_weak(&TraceBuffers, &buffer->next, buffer));
+
+    LocalTraceBuffer = buffer;
+    return buffer;
+}
+
+TraceSpan BeginTraceSpan(const char * name){
+
+    TraceSpan span = {name, MetricsNow()};
+    return span;
+}
+
+void EndTraceSpan(TraceSpan * span){
+
+    unsigned long long end = MetricsNow();
+
+    TraceBuffer * buffer = GetLocalTraceBuffer();
+
+    if (buffer->last->count == TRACE_CHUNK_EVENTS){
+        buffer->last->next = alloc_TraceChunk();
+        buffer->last = buffer->last->next;
+    }
+
+    TraceEvent * event = &buffer->last->events[buffer->last->count++];
+    event->name = span->name;
+    event->start = span->start;
+    event->duration = end - span->start;
+}
+
+#pragma endregion
+
+#pragma region [OUTPUT]
+
+/**
+ * Writes every recorded span as a complete ("X") event. Timestamps are in microseconds from InitializeTrace(), with nanosecond decimals.
+ */
+void WriteTrace(FILE * out){
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"BattleShip\"}}");
+
+    for (TraceBuffer * buffer = atomic_load(&TraceBuffers); buffer != NULL; buffer = buffer->next)
+    {
+        if (buffer->threadId == 0){
+            fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"game\"}}");
+        }
+        else {
+            fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+                buffer->threadId, buffer->threadId);
+        }
+
+        for (TraceChunk * chunk = buffer->first; chunk != NULL; chunk = chunk->next)
+        {
+            for (int i = 0; i < chunk->count; i++)
+            {
+                TraceEvent * event = &chunk->events[i];
+                unsigned long long ts = (event->start > TraceStart) ? event->start - TraceStart : 0;
+
+                fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}",
+                    event->name, buffer->threadId, ts / 1000, ts % 1000, event->duration / 1000, event->duration % 1000);
+            }
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+    fflush(out);
+}
+
+static void WriteTraceToDestination(){
+
+    const char * path = getenv("BATTLESHIP_TRACE");
+    FILE * out = fopen((path != NULL) ? path : "trace.json", "w");
+
+    if (out == NULL){
+        fprintf(stderr, "Could not write the trace to %s.\n", (path != NULL) ? path : "trace.json");
+        return;
+    }
+
+    WriteTrace(out);
+    fclose(out);
+}
+
+#pragma endregion
+
+#pragma region [TRIGGERS]
+
+/**
+ * Writes the trace, then hands the signal to whoever handled it before (the metrics summary, or the default handler).
+ */
+static void HandleTraceSignal(int sig){
+
+    WriteTraceToDestination();
+
+    void (*previous)(int) = (sig == SIGINT) ? PreviousIntHandler : PreviousTermHandler;
+
+    if (previous == SIG_IGN) return;
+
+    if (previous == SIG_DFL || previous == SIG_ERR){
+        signal(sig, SIG_DFL);
+        raise(sig);
+        return;
+    }
+
+    previous(sig);
+}
+
+void InitializeTrace(){
+
+    TraceStart = MetricsNow();
+
+    //The thread starting the game gets id 0:
+    GetLocalTraceBuffer();
+
+    atexit(WriteTraceToDestination);
+
+    PreviousIntHandler = signal(SIGINT, HandleTraceSignal);
+    PreviousTermHandler = signal(SIGTERM, HandleTraceSignal);
+}
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,66 @@
+#include "../include/Transposition.h"
+#include "../include/Player.h"
+#include "../include/Metrics.h"
+
+typedef struct TranspositionSlot{
+    volatile unsigned long long check; //key ^ data
+    volatile unsigned long long data;
+} TranspositionSlot;
+
+//Static, so it needs no allocation and every thread sees the same table from the start:
+static TranspositionSlot TranspositionTable[TRANSPOSITION_ENTRIES];
+
+/**
+ * Hash of the knowledge before any shot: only the fleet counts.
+ */
+unsigned long long InitialKnowledgeHash(Fleet * fleet){
+
+    unsigned long long hash = 0;
+
+    for (int length = 1; length <= fleet->maxLength; length++)
+    {
+        if (fleet->afloatByLength[length] > 0) hash ^= ZobristFleetKey(length, fleet->afloatByLength[length]);
+    }
+
+    return hash;
+}
+
+static unsigned long long TranspositionKey(Player * player, TranspositionQuery query, int argument){
+
+    return player->knowledgeHash ^ ZobristKey(((unsigned long long)(query + 1) << 56) ^ (unsigned int)argument);
+}
+
+/**
+ * Returns 1 and fills data if the result of the query for the player's current knowledge is cached, 0 otherwise.
+ */
+int ProbeTransposition(Player * player, TranspositionQuery query, int argument, unsigned long long * data){
+
+    if (player->placementPrior != NULL) return 0;
+
+    unsigned long long key = TranspositionKey(player, query, argument);
+    TranspositionSlot * slot = &TranspositionTable[key & (TRANSPOSITION_ENTRIES - 1)];
+
+    unsigned long long check = slot->check;
+    unsigned long long value = slot->data;
+
+    if ((check ^ value) != key){
+        METRIC_COUNT(COUNTER_TRANSPOSITION_MISSES);
+        return 0;
+    }
+
+    METRIC_COUNT(COUNTER_TRANSPOSITION_HITS);
+
+    *data = value;
+    return 1;
+}
+
+void StoreTransposition(Player * player, TranspositionQuery query, int argument, unsigned long long data){
+
+    if (player->placementPrior != NULL) return;
+
+    unsigned long long key = TranspositionKey(player, query, argument);
+    TranspositionSlot * slot = &TranspositionTable[key & (TRANSPOSITION_ENTRIES - 1)];
+
+    slot->check = key ^ data;
+    slot->data = data;
+}
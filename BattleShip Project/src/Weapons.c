@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include "../include/defs.h"
+#include "../include/Player.h"
+#include "../include/Weapons.h"
+#include "../include/Transposition.h"
+#include "../include/ShortcutFuncs.h"
+
+/**
+ * The weapons of the game. The order must follow the WeaponID enum.
+ */
+WeaponDef WeaponTable[WEAPONCOUNT] = {
+    [WEAPON_FIRE] = {
+        .name = "fire", .shape = SHAPE_STENCIL, .height = 1, .width = 1, .stencil = STENCIL_RECT,
+        .effect = EFFECT_HIT, .ammoType = AMMO_UNLIMITED, .unlock = UNLOCK_ALWAYS,
+        .rejectRepeatedHit = true, .missMsg = "Miss"
+    },
+    [WEAPON_RADAR] = {
+        .name = "radar", .shape = SHAPE_STENCIL, .height = RADAR_HEIGHT, .width = RADAR_WIDTH, .stencil = STENCIL_RECT,
+        .effect = EFFECT_REVEAL, .ammoType = AMMO_FIXED, .ammo = 3, .unlock = UNLOCK_ALWAYS,
+        .lockedMsg = "No more radar sweeps allowed! You lose your turn.", .lockedLosesTurn = 1
+    },
+    [WEAPON_SMOKE] = {
+        .name = "smoke", .shape = SHAPE_STENCIL, .height = SMOKE_HEIGHT, .width = SMOKE_WIDTH, .stencil = STENCIL_RECT,
+        .effect = EFFECT_SMOKE, .ammoType = AMMO_PER_SUNK_SHIP, .unlock = UNLOCK_ALWAYS,
+        .lockedMsg = "You cannot use more smoke screens than the ships you've sunk!"
+    },
+    [WEAPON_ARTILLERY] = {
+        .name = "artillery", .shape = SHAPE_STENCIL, .height = ARTILLERY_HEIGHT, .width = ARTILLERY_WIDTH, .stencil = STENCIL_RECT,
+        .effect = EFFECT_HIT, .ammoType = AMMO_UNLIMITED, .unlock = UNLOCK_AFTER_SINKING, .minOpponentSunk = 0,
+        .lockedMsg = "Artillery can only be used in the round right after sinking an opponent's ship!", .missMsg = "Miss!"
+    },
+    [WEAPON_TORPEDO] = {
+        .name = "torpedo", .shape = SHAPE_LINE,
+        .effect = EFFECT_HIT, .ammoType = AMMO_UNLIMITED, .unlock = UNLOCK_AFTER_SINKING, .minOpponentSunk = 3,
+        .lockedMsg = "Torpedo can only be used after sinking the opponent's third ship!", .missMsg = "Miss."
+    }
+};
+
+typedef struct{
+    Player * attacker; //Keeps the misses the grid hides (see RecordHiddenMiss()). May be NULL.
+    int hits;
+    int lastHitShip;
+    int sunkShip;
+    int sunkCount;
+} HitResult;
+
+/**
+ * Builds the message shown after a ship cell is hit. Thanks to the shipIdGrid we know right away which ship was hit and whether it sank.
+ */
+static char * alloc_HitMessage(Player * target, int shipID, int sunk){
+
+    char * shipName = ShipTypeName(target->fleet.length[shipID]);
+
+    if (sunk > 0) return CreateString_alloc(3, "Hit! You sunk the ", shipName, "!");
+
+    return CreateString_alloc(3, "Hit the ", shipName, "!");
+}
+
+/**
+ * Returns 1 if the attacker can use the weapon on the target this turn, and 0 if it is locked or out of ammo.
+ */
+int CanUseWeapon(WeaponID weaponID, Player * attacker, Player * target){
+
+    WeaponDef * weapon = &WeaponTable[weaponID];
+
+    if (weapon->unlock == UNLOCK_AFTER_SINKING){
+        if (attacker == NULL || attacker->prevSunk == 0) return 0;
+        if (countSunkShips(target) < weapon->minOpponentSunk) return 0;
+    }
+
+    switch (weapon->ammoType)
+    {
+    case AMMO_FIXED:
+        return attacker != NULL && attacker->weaponUses[weaponID] < weapon->ammo;
+    case AMMO_PER_SUNK_SHIP:
+        return attacker != NULL && attacker->weaponUses[weaponID] < attacker->enemyShipsSunk;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * Applies a hit to a single cell of the target's grid. Ship cells are credited to their ship through the shipIdGrid. Every cell that gets
+ * resolved updates the target's probabilities, whoever the attacker is (see UpdateShotProbabilities()).
+ */
+static inline void HitCell(Player * target, int i, int j, int difficulty, HitResult * result){
+
+    char * c = &(target->grid)[i][j];
+
+    if (IsShip(*c)){
+        int shipID = (target->shipIdGrid)[i][j];
+        int sunkShip = NOSHIP_ID;
+
+        result->lastHitShip = shipID;
+        if (RegisterShipHit(target, shipID) > 0){
+            sunkShip = shipID;
+            result->sunkShip = shipID;
+            result->sunkCount++;
+        }
+
+        *c = HIT;
+        target->knowledgeHash ^= ZobristCellKey(i, j, HIT);
+        result->hits++;
+        target->resolvedCells++;
+
+        UpdateShotProbabilities(target, i, j, sunkShip);
+    }
+    else if (*c != HIT && *c != MISS && difficulty == 0){
+        *c = MISS;
+        target->resolvedCells++;
+        target->knowledgeHash ^= ZobristCellKey(i, j, MISS);
+
+        UpdateShotProbabilities(target, i, j, NOSHIP_ID);
+    }
+    else if (*c != HIT && *c != MISS && result != NULL && result->attacker != NULL){
+        RecordHiddenMiss(result->attacker, target, i, j);
+    }
+}
+
+static inline void SmokeCell(Player * player, int i, int j){
+    (player->smokeGrid)[i][j] = true;
+}
+
+/**
+ * Runs the effect of a hit or smoke weapon over its footprint. Full rectangles get unrolled fast paths for the built-in 1x1 and 2x2 shapes,
+ * other rectangles get a clipped double loop, and custom stencils only visit their set bits.
+ */
+static void ApplyFootprint(WeaponDef * weapon, Player * player, int row, int col, int difficulty, HitResult * result){
+
+    bool smoke = weapon->effect == EFFECT_SMOKE;
+
+    if (weapon->shape == SHAPE_LINE){
+        //row < 0 means the torpedo runs down column col, otherwise it runs across row row.
+        for (int k = 0; k < GRIDSIZE; k++)
+        {
+            int i = (row < 0) ? k : row;
+            int j = (row < 0) ? col : k;
+
+            if (smoke) SmokeCell(player, i, j);
+            else HitCell(player, i, j, difficulty, result);
+        }
+        return;
+    }
+
+    if (weapon->stencil == STENCIL_RECT){
+
+        if (weapon->height == 1 && weapon->width == 1){
+            if (smoke) SmokeCell(player, row, col);
+            else HitCell(player, row, col, difficulty, result);
+            return;
+        }
+
+        if (weapon->height == 2 && weapon->width == 2 && row + 1 < GRIDSIZE && col + 1 < GRIDSIZE){
+            if (smoke){
+                SmokeCell(player, row, col);
+                SmokeCell(player, row, col + 1);
+                SmokeCell(player, row + 1, col);
+                SmokeCell(player, row + 1, col + 1);
+            }
+            else {
+                HitCell(player, row, col, difficulty, result);
+                HitCell(player, row, col + 1, difficulty, result);
+                HitCell(player, row + 1, col, difficulty, result);
+                HitCell(player, row + 1, col + 1, difficulty, result);
+            }
+            return;
+        }
+
+        int rowEnd = MIN(GRIDSIZE, row + weapon->height);
+        int colEnd = MIN(GRIDSIZE, col + weapon->width);
+
+        for (int i = row; i < rowEnd; i++)
+        {
+            for (int j = col; j < colEnd; j++)
+            {
+                if (smoke) SmokeCell(player, i, j);
+                else HitCell(player, i, j, difficulty, result);
+            }
+        }
+        return;
+    }
+
+    unsigned long long bits = weapon->stencil;
+
+    while (bits != 0)
+    {
+        int bit = __builtin_ctzll(bits);
+        bits &= bits - 1;
+
+        int i = row + bit / STENCIL_SIZE;
+        int j = col + bit % STENCIL_SIZE;
+
+        if (i >= GRIDSIZE || j >= GRIDSIZE) continue;
+
+        if (smoke) SmokeCell(player, i, j);
+        else HitCell(player, i, j, difficulty, result);
+    }
+}
+
+/**
+ * Counts the unsmoked ship cells under a reveal footprint. Rectangles are a single summed-area table query.
+ */
+static int RevealFootprint(WeaponDef * weapon, Player * target, int row, int col){
+
+    if (weapon->shape == SHAPE_LINE){
+        return (row < 0) ? QueryRadarArea(target, 0, GRIDSIZE - 1, col, col) : QueryRadarArea(target, row, row, 0, GRIDSIZE - 1);
+    }
+
+    if (weapon->stencil == STENCIL_RECT){
+        return QueryRadarArea(target, row, row + weapon->height - 1, col, col + weapon->width - 1);
+    }
+
+    int found = 0;
+    unsigned long long bits = weapon->stencil;
+
+    while (bits != 0)
+    {
+        int bit = __builtin_ctzll(bits);
+        bits &= bits - 1;
+
+        int i = row + bit / STENCIL_SIZE;
+        int j = col + bit % STENCIL_SIZE;
+
+        found += QueryRadarArea(target, i, i, j, j);
+    }
+
+    return found;
+}
+
+/**
+ * The generic weapon kernel. It checks the weapon's unlock and ammo rules, runs its effect over its footprint and stores the message to
+ * be printed by the driver in outputMsg.
+ *
+ * Input:
+ *      - attacker: the player using the weapon (may be NULL for weapons with no ammo or unlock rules)
+ *      - target: the player being attacked. Smoke is applied to the attacker's own grid instead.
+ *      - row, col: the targeted cell in array coordinates. For line weapons, a negative row targets column col and a negative col targets row row.
+ *
+ * Output:
+ *      - 1 if the turn was spent, -1 if the move was refused and the player should pick another one.
+ */
+int ApplyWeapon(WeaponID weaponID, Player * attacker, Player * target, int row, int col, int difficulty, char ** outputMsg){
+
+    WeaponDef * weapon = &WeaponTable[weaponID];
+
+    if (!CanUseWeapon(weaponID, attacker, target)){
+        if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, weapon->lockedMsg);
+        return (weapon->lockedLosesTurn) ? 1 : -1;
+    }
+
+    if (weapon->rejectRepeatedHit && (target->grid)[row][col] == HIT){
+        if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, "This coordinate has already been hit.");
+        return -1;
+    }
+
+    if (attacker != NULL) attacker->weaponUses[weaponID]++;
+
+    switch (weapon->effect)
+    {
+    case EFFECT_REVEAL:{
+        int found = RevealFootprint(weapon, target, row, col);
+
+        if (outputMsg != NULL) *outputMsg = (found > 0) ? CreateString_alloc(1, "Enemy ships found") : CreateString_alloc(1, "No enemy ships found");
+        break;
+    }
+    case EFFECT_SMOKE:{
+        ApplyFootprint(weapon, attacker, row, col, difficulty, NULL);
+
+        UpdateRadarAreaTable(attacker, MAX(0, row), MAX(0, col));
+
+        if (outputMsg != NULL) *outputMsg = CreateString_alloc(1, "Smoke screen applied.");
+        break;
+    }
+    default:{
+        HitResult result = {attacker, 0, NOSHIP_ID, NOSHIP_ID, 0};
+
+        //How a human searches is part of their profile (torpedoes target a whole line, so they are left out):
+        RecordEarlyShot(attacker, row, col);
+
+        ApplyFootprint(weapon, target, row, col, difficulty, &result);
+
+        if (attacker != NULL) attacker->enemyShipsSunk += result.sunkCount;
+
+        if (outputMsg != NULL){
+            if (result.hits == 0) *outputMsg = CreateString_alloc(1, weapon->missMsg);
+            else if (result.sunkShip != NOSHIP_ID) *outputMsg = alloc_HitMessage(target, result.sunkShip, 1);
+            else *outputMsg = alloc_HitMessage(target, result.lastHitShip, 0);
+        }
+        break;
+    }
+    }
+
+    return 1;
+}
@@ -5,6 +5,7 @@
 
 #include <math.h>
 #include "../include/coordslib.h"
+#include "../include/Memory.h"
 
 const char startingCoordinate_1 = 'A';
 const char endingCoordinate_1 = 'Z';
@@ -142,7 +143,7 @@ int * alloc_ArrayCoordsFromUserCoords(char coords[], char ** outputMsg){
     int j = CoordToIndex(coords, 0, split + 1, startingCoordinate_1, endingCoordinate_1, coord_1_shift);
     int i = CoordToIndex(coords, split + 1, coordsLen, startingCoordinate_2, endingCoordinate_2, coord_2_shift);
 
-    //if (*outputMsg != NULL) free(*outputMsg); //In case the CoordToIndex returns an error message.
+    //if (*outputMsg != NULL) FreeTracked(*outputMsg); //In case the CoordToIndex returns an error message.
 
     if (!IndexWithinRange(i) || !IndexWithinRange(j)){
         
@@ -152,7 +153,7 @@ int * alloc_ArrayCoordsFromUserCoords(char coords[], char ** outputMsg){
 
     
 
-    int *result = (int *)(malloc(sizeof(int) * 2));
+    int *result = (int *)(alloc_Tracked(MEM_STRINGS, sizeof(int) * 2));
     result[0] = i;
     result[1] = j;
 
@@ -187,7 +188,7 @@ int *alloc_GridAreaFromInput (char startingCoords[], char orientation[], int wid
         width = height;
         height = temp;
     }
-    int * bounds = (int *)(malloc(sizeof(int) * 4));
+    int * bounds = (int *)(alloc_Tracked(MEM_STRINGS, sizeof(int) * 4));
 
 
     bounds[0] = startArrayCoords[0];
@@ -195,7 +196,7 @@ int *alloc_GridAreaFromInput (char startingCoords[], char orientation[], int wid
     bounds[2] = startArrayCoords[1];
     bounds[3] = startArrayCoords[1] + width;
 
-    free(startArrayCoords);
+    FreeTracked(startArrayCoords);
 
     return bounds;
 
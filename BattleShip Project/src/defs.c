@@ -1,7 +1,9 @@
 #include "../include/defs.h"
 
 
-char* GameModeStrings[2] = { "PVP", "PVE" };
+char* GameModeStrings[GAMEMODECOUNT] = { "PVP", "PVE", "FFA" };
 char* DifficultyStrings[2] = {"easy", "hard"};
+int GameShipCount = SHIPCOUNT;
+int GameShipLengths[MAXSHIPCOUNT] = SHIPSIZES;
 
 int DifficultyValue;
\ No newline at end of file
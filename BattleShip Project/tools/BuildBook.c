@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/Player.h"
+#include "../include/OpeningBook.h"
+#include "../include/Memory.h"
+
+/**
+ * Writes the opening book of one configuration (see include/OpeningBook.h). GRIDSIZE is a compile-time constant, so a builder only writes
+ * books for the grid size it was compiled with.
+ *
+ * Usage: build_book [directory] [ship lengths...]
+ * The directory defaults to books/ and must exist. Without ship lengths the book is written for the default fleet (SHIPSIZES).
+ */
+
+#define BOOK_SEED 0x9E3779B97F4A7C15ULL
+
+int main(int argc, char ** argv){
+
+    const char * directory = (argc > 1) ? argv[1] : "books";
+
+    if (argc > 2){
+        int shipLengths[MAXSHIPCOUNT];
+        int shipCount = 0;
+
+        for (int a = 2; a < argc && shipCount < MAXSHIPCOUNT; a++)
+        {
+            shipLengths[shipCount++] = atoi(argv[a]);
+        }
+
+        if (SetGameFleet(shipLengths, shipCount) < 0){
+            fprintf(stderr, "Invalid fleet: every ship must be between 1 and %d cells long.\n", GRIDSIZE);
+            return 1;
+        }
+    }
+
+    char * path = NULL;
+
+    if (WriteOpeningBook(directory, GameShipLengths, GameShipCount, BOOK_SEED, &path) < 0){
+        fprintf(stderr, "Could not write the opening book to %s.\n", path);
+        FreeTracked(path);
+        return 1;
+    }
+
+    fprintf(stderr, "Wrote %s (%d x %d grid, %d ships, %d lines of %d shots).\n", path, GRIDSIZE, GRIDSIZE, GameShipCount,
+        OPENINGBOOK_LINECOUNT, OPENINGBOOK_LINELENGTH);
+    FreeTracked(path);
+
+    return 0;
+}